@@ -2,7 +2,11 @@
  
 #include <pebble.h>
 
-#define ISOMETRIC_OPTIMIZE_FILL_BOX // Only draw front of a box to save time
+// Deprecated, has no effect since 1.5.0. Boxes only ever fill their visible faces
+#define ISOMETRIC_OPTIMIZE_FILL_BOX
+
+// Rasterised boxes kept for reuse before the least recently used is replaced
+#define ISOMETRIC_MAX_STAMPS 32
 
 typedef struct {
   int16_t x;
@@ -12,6 +16,14 @@ typedef struct {
 
 #define Vec3(x, y, z) ((Vec3){(x),(y),(z)})
 
+typedef struct {
+  GColor *voxels;  // width * height * depth colors, x fastest then y then z. GColorClear is empty
+  int width;
+  int height;
+  int depth;
+  int voxel_size;  // Side length of each voxel
+} IsometricVoxelGrid;
+
 /**
  * Begin isometric drawing. Sets up internal frame buffer data.
  * Call this first.
@@ -37,6 +49,41 @@ void isometric_set_enabled(bool b);
  */
 void isometric_set_projection_offset(GPoint offset);
 
+/**
+ * Toggle the depth buffer. While enabled, a pixel is only drawn if it is at
+ * least as near as what was already drawn there, so shapes can be drawn in any
+ * order instead of back to front. Only applies in isometric projection.
+ * Where shapes meet in the same plane, the last drawn still owns the shared edge.
+ *
+ * Note: Uses one byte per framebuffer pixel of heap, allocated in the next
+ * isometric_begin() and freed when disabled
+ */
+void isometric_set_depth_buffer_enabled(bool enabled);
+
+/**
+ * Set the size of one depth step in the depth buffer to 2^shift world units.
+ * Depth is x + y + z, so increase this until the nearest point of the scene is
+ * under 256 steps. Keep the scene at positive coordinates.
+ */
+void isometric_set_depth_scale(int shift);
+
+/**
+ * Toggle draw lists. While enabled, draw calls between isometric_begin() and
+ * isometric_finish() are recorded instead of drawn. If the list is the same
+ * as last frame, isometric_finish() copies what it drew then from an offscreen
+ * bitmap, otherwise it draws the list and keeps a copy.
+ *
+ * Note: The copy includes whatever was in the framebuffer before isometric_begin(),
+ * call isometric_invalidate_draw_list() when that changes. Textures and voxel
+ * grids are compared by their data, and must stay valid until isometric_finish().
+ */
+void isometric_set_draw_list_enabled(bool enabled);
+
+/**
+ * Draw the next list even if it is the same as the last one
+ */
+void isometric_invalidate_draw_list();
+
 /**
  * Project any point from screen space to isometric space
  */
@@ -57,6 +104,12 @@ void isometric_fill_rect(Vec3 origin, GSize size, GColor color);
  */
 void isometric_fill_box(Vec3 origin, GSize size, int z_height, GColor color);
 
+/**
+ * Fill an isometric box with z height, with a different color for each visible face.
+ * The right face is on the x + size.w side, the left face on the y + size.h side.
+ */
+void isometric_fill_box_shaded(Vec3 origin, GSize size, int z_height, GColor top, GColor right, GColor left);
+
 /**
  * Draw an isometric box with z height
  */
@@ -80,4 +133,27 @@ void isometric_draw_box_faces(Vec3 origin, GSize size, int z_height, GColor colo
 /**
  * Fill individual faces of an isometric box
  */
-void isometric_fill_box_faces(Vec3 origin, GSize size, int z_height, GColor color, bool top, bool right, bool left);
\ No newline at end of file
+void isometric_fill_box_faces(Vec3 origin, GSize size, int z_height, GColor color, bool top, bool right, bool left);
+
+/**
+ * Fill a box like isometric_fill_box_shaded(), with outlines like isometric_draw_box().
+ * The first box of each size and colors is recorded as a set of row spans, and
+ * any identical box after that is stamped from the recording instead of being
+ * rasterised again.
+ *
+ * Note: outline can be GColorClear to not draw outlines
+ */
+void isometric_stamp_box(Vec3 origin, GSize size, int z_height, GColor top, GColor right, GColor left, GColor outline);
+
+/**
+ * Free all recorded box stamps
+ */
+void isometric_clear_stamps();
+
+/**
+ * Draw a grid of voxels with its first voxel at origin, back to front.
+ * Faces covered by a neighbouring voxel, and voxels with none left, are skipped.
+ *
+ * Note: outline_color can be GColorClear to not draw outlines
+ */
+void isometric_draw_voxel_grid(IsometricVoxelGrid *grid, Vec3 origin, GColor outline_color);
@@ -2,23 +2,335 @@
 
 #include <pebble-universal-fb/pebble-universal-fb.h>
 
+// Tallest display of any platform
+#define MAX_ROWS 228
+
 static GBitmap *s_fb = NULL;
 static GSize s_fb_size;
-static GBitmapDataRowInfo s_info;
 static GPoint s_projection_offset;
 
 static bool s_enabled = true;
 static uint8_t *s_fb_data = NULL;
 
-static void set_pixel(GPoint pixel, GColor color) {
-  GColor actual_color = color;
+// Data and drawable extent of every framebuffer row, fetched once per frame
+static GBitmapDataRowInfo s_rows[MAX_ROWS];
+
+// Anything outside s_clip is never drawn, anything inside s_clip_inner always is.
+// They only differ on round displays.
+static GRect s_clip, s_clip_inner;
+
+// One byte per framebuffer pixel, nearer is larger and 0 is nothing drawn yet
+static uint8_t *s_depth_buffer = NULL;
+static bool s_depth_enabled = false;
+static int s_depth_shift = 0;
+
+// Twice the depth of what is being drawn at screen x, y is a * x + b * y + c
+static int s_depth_a, s_depth_b, s_depth_c;
+
+// Left and right extent of a polygon on each row while it is filled
+static int16_t s_span_left[MAX_ROWS], s_span_right[MAX_ROWS];
+
+// Visible faces of a box
+#define FACE_TOP (1 << 0)
+#define FACE_RIGHT (1 << 1)
+#define FACE_LEFT (1 << 2)
+#define FACE_ALL (FACE_TOP | FACE_RIGHT | FACE_LEFT)
+
+// Most spans recorded for one stamp
+#define MAX_STAMP_SPANS 256
+
+typedef struct {
+  int16_t x0;
+  int16_t x1;
+  GColor color;
+} StampSpan;
+
+typedef struct {
+  GSize size;
+  int16_t z_height;
+  GColor top, right, left, outline;
+  uint8_t faces;
+  int8_t x_parity, y_parity;  // How the projection rounds at this position
+} StampKey;
+
+typedef struct {
+  uint32_t hash;
+  StampKey key;
+  GPoint offset;         // Top left of the stamp from the projected origin
+  uint16_t width;
+  uint16_t num_rows;
+  uint16_t *row_starts;  // Index of the first span of each row, and one past the last
+  StampSpan *spans;
+  uint32_t last_used;
+} Stamp;
+
+static Stamp s_stamps[ISOMETRIC_MAX_STAMPS];
+static uint32_t s_stamp_clock;
+
+// Where spans go instead of the framebuffer while a stamp is recorded
+static StampSpan *s_record_spans = NULL;
+static uint16_t *s_record_rows = NULL;
+static int s_num_record_spans;
+static bool s_record_overflow;
+
+static void record_span(int y, int x0, int x1, GColor color) {
+  if (y < 0 || y >= s_clip.size.h) {
+    return;
+  }
+
+  // Extend the last span where it continues on the same row, as lines do
+  if (s_num_record_spans > 0) {
+    StampSpan *last = &s_record_spans[s_num_record_spans - 1];
+    if (s_record_rows[s_num_record_spans - 1] == y && gcolor_equal(last->color, color)
+        && x0 <= last->x1 + 1 && x1 >= last->x0 - 1) {
+      last->x0 = (x0 < last->x0) ? x0 : last->x0;
+      last->x1 = (x1 > last->x1) ? x1 : last->x1;
+      return;
+    }
+  }
+
+  if (s_num_record_spans == MAX_STAMP_SPANS) {
+    s_record_overflow = true;
+    return;
+  }
+  s_record_spans[s_num_record_spans] = (StampSpan) { .x0 = x0, .x1 = x1, .color = color };
+  s_record_rows[s_num_record_spans] = y;
+  s_num_record_spans++;
+}
+
+typedef enum {
+  ListCommandSetEnabled = 0,
+  ListCommandSetProjectionOffset,
+  ListCommandDrawRect,
+  ListCommandFillRect,
+  ListCommandFillBoxShaded,
+  ListCommandDrawBox,
+  ListCommandDrawPixel,
+  ListCommandFillTexturedRect,
+  ListCommandDrawBoxFaces,
+  ListCommandFillBoxFaces,
+  ListCommandStampBox,
+  ListCommandDrawVoxelGrid
+} ListCommandType;
+
+// Arguments of one recorded draw call, the meaning of each depends on the type
+typedef struct {
+  uint8_t type;
+  uint8_t flags;
+  Vec3 origin;
+  GSize size;
+  int16_t z_height;
+  GColor colors[4];
+  uint8_t unused[2];   // Zeroed, so there is no padding and lists can be memcmp()'d
+  uint32_t data_hash;  // Of what data points to, so changes to it are seen
+  void *data;          // Texture or voxel grid
+} ListCommand;
+
+#define LIST_FLAG_A (1 << 0)
+#define LIST_FLAG_B (1 << 1)
+#define LIST_FLAG_C (1 << 2)
+
+static bool s_list_enabled = false;
+static bool s_list_recording = false;
+static ListCommand *s_list = NULL;
+static int s_list_length, s_list_capacity;
+static uint32_t s_list_hash;
+static GBitmap *s_list_cache = NULL;  // The framebuffer as the last list left it
+static bool s_list_cache_valid = false;
+
+// The list that drew the cache, to confirm a matching hash is not a collision
+static ListCommand *s_list_prev = NULL;
+static int s_list_prev_length, s_list_prev_capacity;
+static bool s_list_prev_enabled;
+static GPoint s_list_prev_offset;
+
+// Drawing state when recording began, to replay from
+static bool s_list_start_enabled;
+static GPoint s_list_start_offset;
+
+static uint32_t hash_bytes(uint32_t hash, const uint8_t *bytes, int length) {
+  // FNV-1a
+  for (int i = 0; i < length; i++) {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+  return hash;
+}
+
+static uint32_t hash_int(uint32_t hash, int value) {
+  return hash_bytes(hash, (const uint8_t*)&value, sizeof(value));
+}
+
+static void replay_list();
+
+/**
+ * Add a draw call to the list. If the list cannot grow, draw what it holds so
+ * far and stop recording for the rest of this frame, so the caller must draw.
+ */
+static bool record_command(ListCommand command) {
+  if (s_list_length == s_list_capacity) {
+    int capacity = (s_list_capacity == 0) ? 32 : s_list_capacity * 2;
+    ListCommand *list = realloc(s_list, capacity * sizeof(ListCommand));
+    if (!list) {
+      APP_LOG(APP_LOG_LEVEL_ERROR, "Not enough memory for draw list, drawing directly");
+      replay_list();
+      s_list_recording = false;
+      s_list_cache_valid = false;
+      return false;
+    }
+    s_list = list;
+    s_list_capacity = capacity;
+  }
+  s_list[s_list_length++] = command;
+  return true;
+}
+
 #if defined(PBL_BW)
-  // Dither black and white if gray requested
-  if (gcolor_equal(color, GColorDarkGray) || gcolor_equal(color, GColorLightGray)) {
-    actual_color = (pixel.x % 2 == 0) ? GColorWhite : GColorBlack;
+// Order in which the pixels of each 4 x 4 block turn white as colors get lighter
+static const uint8_t s_bayer[4][4] = {
+  { 0,  8,  2, 10},
+  {12,  4, 14,  6},
+  { 3, 11,  1,  9},
+  {15,  7, 13,  5}
+};
+
+// For each of the 17 shades from black to white, the pixels of each row of a
+// block that are white, twice over to fill a byte
+static uint8_t s_dither_patterns[17][4];
+static bool s_dither_patterns_ready = false;
+
+static void build_dither_patterns() {
+  for (int level = 0; level <= 16; level++) {
+    for (int y = 0; y < 4; y++) {
+      uint8_t pattern = 0;
+      for (int x = 0; x < 4; x++) {
+        if (s_bayer[y][x] < level) {
+          pattern |= (1 << x) | (1 << (x + 4));
+        }
+      }
+      s_dither_patterns[level][y] = pattern;
+    }
   }
+  s_dither_patterns_ready = true;
+}
+
+/**
+ * Shade of a color from 0 (black) to 16 (white), by perceived brightness
+ */
+static int get_shade(GColor color) {
+  int luminance = (2 * color.r) + (5 * color.g) + color.b;  // Up to 24
+  return ((luminance * 16) + 12) / 24;
+}
+
+/**
+ * Pixels of row y to set white for a color, repeating every 4 pixels
+ */
+static uint8_t get_fill_pattern(GColor color, int y) {
+  return s_dither_patterns[get_shade(color)][y & 3];
+}
 #endif
-  universal_fb_set_pixel_color(s_info, gbitmap_get_bounds(s_fb), pixel, actual_color);
+
+static bool is_depth_tested() {
+  return s_depth_buffer && s_enabled && !s_record_spans;
+}
+
+/**
+ * Depth of what is being drawn at a pixel
+ */
+static uint8_t get_depth(int x, int y) {
+  int depth = ((s_depth_a * x) + (s_depth_b * y) + s_depth_c) >> (1 + s_depth_shift);
+  return (depth < 1) ? 1 : ((depth > 255) ? 255 : depth);
+}
+
+/**
+ * The viewer looks along (-1, -1, -1), so depth is x + y + z. For each plane,
+ * find it from the screen position by undoing isometric_project().
+ */
+static void set_depth_plane_x(int x) {
+  s_depth_a = -3;
+  s_depth_b = -2;
+  s_depth_c = (6 * x) + (3 * s_projection_offset.x) + (2 * s_projection_offset.y);
+}
+
+static void set_depth_plane_y(int y) {
+  s_depth_a = 3;
+  s_depth_b = -2;
+  s_depth_c = (6 * y) - (3 * s_projection_offset.x) + (2 * s_projection_offset.y);
+}
+
+static void set_depth_plane_z(int z) {
+  s_depth_a = 0;
+  s_depth_b = 4;
+  s_depth_c = (6 * z) - (4 * s_projection_offset.y);
+}
+
+static bool is_visible(int x, int y) {
+  return y >= 0 && y < s_clip.size.h && x >= s_rows[y].min_x && x <= s_rows[y].max_x;
+}
+
+/**
+ * Set a pixel already known to be visible
+ */
+static void plot_pixel(int x, int y, GColor color) {
+  if (s_record_spans) {
+    record_span(y, x, x, color);
+    return;
+  }
+
+  if (is_depth_tested()) {
+    uint8_t depth = get_depth(x, y);
+    uint8_t *stored = &s_depth_buffer[(y * s_fb_size.w) + x];
+    if (depth < *stored) {
+      // Behind what is already there
+      return;
+    }
+    *stored = depth;
+  }
+
+#if defined(PBL_COLOR)
+  s_rows[y].data[x] = color.argb;
+#elif defined(PBL_BW)
+  uint8_t bit = 1 << (x % 8);
+  if (gcolor_equal(color, GColorWhite)) {
+    s_rows[y].data[x / 8] |= bit;
+  } else {
+    s_rows[y].data[x / 8] &= ~bit;
+  }
+#endif
+}
+
+static GColor get_pixel_color(int x, int y, GColor color) {
+#if defined(PBL_BW)
+  if (s_record_spans) {
+    // Left for when a stamp is drawn, where it is on screen
+    return color;
+  }
+
+  // The same pixel of the dither pattern a span would set
+  return ((get_fill_pattern(color, y) >> (x & 3)) & 1) ? GColorWhite : GColorBlack;
+#else
+  return color;
+#endif
+}
+
+static void set_pixel(GPoint pixel, GColor color) {
+  if (s_record_spans || is_visible(pixel.x, pixel.y)) {
+    plot_pixel(pixel.x, pixel.y, get_pixel_color(pixel.x, pixel.y, color));
+  }
+}
+
+/**
+ * Find which steps of a line that moves one row per step are on visible rows
+ */
+static void get_visible_steps(int y, int sy, int steps, int *first, int *last) {
+  if (sy > 0) {
+    *first = -y;
+    *last = s_clip.size.h - 1 - y;
+  } else {
+    *first = y - (s_clip.size.h - 1);
+    *last = y;
+  }
+  *first = (*first < 0) ? 0 : *first;
+  *last = (*last > steps) ? steps : *last;
 }
 
 /**
@@ -32,9 +344,41 @@ static void bresenham_line(GPoint start, GPoint finish, GColor color) {
   int err = ((dx > dy) ? dx : -dy) / 2;
   int e2;
 
-  s_info = gbitmap_get_data_row_info(s_fb, start.y);
+  // Clip the whole line once, and only check each pixel if it is partly visible
+  int min_x = (start.x < finish.x) ? start.x : finish.x;
+  int min_y = (start.y < finish.y) ? start.y : finish.y;
+  int max_x = min_x + dx;
+  int max_y = min_y + dy;
+  if (max_x < s_clip.origin.x || min_x >= s_clip.origin.x + s_clip.size.w
+      || max_y < s_clip.origin.y || min_y >= s_clip.origin.y + s_clip.size.h) {
+    return;
+  }
+  const bool check = min_x < s_clip_inner.origin.x || max_x >= s_clip_inner.origin.x + s_clip_inner.size.w
+    || min_y < s_clip_inner.origin.y || max_y >= s_clip_inner.origin.y + s_clip_inner.size.h;
+
+  if (dx == 0 || dx == 2 * dy) {
+    // Projected box edges are vertical, or two pixels across for every row down,
+    // which Bresenham draws as pairs of pixels ending with a single one
+    int first, last;
+    get_visible_steps(start.y, sy, dy, &first, &last);
+    const int step_x = (dx == 0) ? 0 : 2 * sx;
+    for (int i = first; i <= last; i++) {
+      int x = start.x + (i * step_x);
+      int y = start.y + (i * sy);
+      if (!check || is_visible(x, y)) {
+        plot_pixel(x, y, get_pixel_color(x, y, color));
+      }
+      if (step_x != 0 && i < dy && (!check || is_visible(x + sx, y))) {
+        plot_pixel(x + sx, y, get_pixel_color(x + sx, y, color));
+      }
+    }
+    return;
+  }
+
   while (true) {
-    set_pixel(GPoint(start.x, start.y), color);
+    if (!check || is_visible(start.x, start.y)) {
+      plot_pixel(start.x, start.y, get_pixel_color(start.x, start.y, color));
+    }
     if (start.x == finish.x && start.y == finish.y) break;
 
     e2 = err;
@@ -45,20 +389,491 @@ static void bresenham_line(GPoint start, GPoint finish, GColor color) {
     if (e2 < dy) {
       err += dx;
       start.y += sy;
-      s_info = gbitmap_get_data_row_info(s_fb, start.y);
     }
   }
 }
 
+/**
+ * Write pixels x0 to x1 inclusive on row y in one go, already clipped
+ */
+static void write_span(int y, int x0, int x1, GColor color) {
+  GBitmapDataRowInfo info = s_rows[y];
+#if defined(PBL_COLOR)
+  memset(&info.data[x0], color.argb, x1 - x0 + 1);
+#elif defined(PBL_BW)
+  // One bit per pixel, with partial bytes at either end
+  uint8_t pattern = get_fill_pattern(color, y);
+  int b0 = x0 / 8;
+  int b1 = x1 / 8;
+  uint8_t first = 0xFF << (x0 % 8);
+  uint8_t last = 0xFF >> (7 - (x1 % 8));
+  if (b0 == b1) {
+    first &= last;
+  }
+
+  info.data[b0] = (info.data[b0] & ~first) | (pattern & first);
+  if (b1 > b0) {
+    memset(&info.data[b0 + 1], pattern, b1 - b0 - 1);
+    info.data[b1] = (info.data[b1] & ~last) | (pattern & last);
+  }
+#endif
+}
+
+/**
+ * Write the pixels of a span that pass the depth test, in runs
+ */
+static void write_span_depth_tested(int y, int x0, int x1, GColor color) {
+  uint8_t *stored = &s_depth_buffer[y * s_fb_size.w];
+  int depth = (s_depth_a * x0) + (s_depth_b * y) + s_depth_c;
+  int run_start = -1;
+  for (int x = x0; x <= x1; x++) {
+    int value = depth >> (1 + s_depth_shift);
+    uint8_t clamped = (value < 1) ? 1 : ((value > 255) ? 255 : value);
+    depth += s_depth_a;
+
+    if (clamped >= stored[x]) {
+      stored[x] = clamped;
+      if (run_start < 0) {
+        run_start = x;
+      }
+    } else if (run_start >= 0) {
+      write_span(y, run_start, x - 1, color);
+      run_start = -1;
+    }
+  }
+  if (run_start >= 0) {
+    write_span(y, run_start, x1, color);
+  }
+}
+
+/**
+ * Fill pixels x0 to x1 inclusive on row y in one go
+ */
+static void fill_span(int y, int x0, int x1, GColor color) {
+  if (s_record_spans) {
+    record_span(y, x0, x1, color);
+    return;
+  }
+  if (y < 0 || y >= s_clip.size.h) {
+    return;
+  }
+
+  x0 = (x0 < s_rows[y].min_x) ? s_rows[y].min_x : x0;
+  x1 = (x1 > s_rows[y].max_x) ? s_rows[y].max_x : x1;
+  if (x0 > x1) {
+    return;
+  }
+
+  if (is_depth_tested()) {
+    write_span_depth_tested(y, x0, x1, color);
+  } else {
+    write_span(y, x0, x1, color);
+  }
+}
+
+static void widen_span(int y, int x) {
+  if (x < s_span_left[y]) {
+    s_span_left[y] = x;
+  }
+  if (x > s_span_right[y]) {
+    s_span_right[y] = x;
+  }
+}
+
+/**
+ * Widen the spans of each row the line from start to finish passes through
+ */
+static void walk_edge(GPoint start, GPoint finish) {
+  // Same pixels as bresenham_line(), so fills meet outlines exactly
+  int dx = abs(finish.x - start.x);
+  int sx = (start.x < finish.x) ? 1 : -1;
+  int dy = abs(finish.y - start.y);
+  int sy = (start.y < finish.y) ? 1 : -1;
+  int err = ((dx > dy) ? dx : -dy) / 2;
+  int e2;
+
+  if (dx == 0 || dx == 2 * dy) {
+    // As in bresenham_line()
+    int first, last;
+    get_visible_steps(start.y, sy, dy, &first, &last);
+    const int step_x = (dx == 0) ? 0 : 2 * sx;
+    for (int i = first; i <= last; i++) {
+      int x = start.x + (i * step_x);
+      int y = start.y + (i * sy);
+      widen_span(y, x);
+      if (step_x != 0 && i < dy) {
+        widen_span(y, x + sx);
+      }
+    }
+    return;
+  }
+
+  while (true) {
+    if (start.y >= 0 && start.y < s_clip.size.h) {
+      widen_span(start.y, start.x);
+    }
+    if (start.x == finish.x && start.y == finish.y) break;
+
+    e2 = err;
+    if (e2 > -dx) {
+      err -= dy;
+      start.x += sx;
+    }
+    if (e2 < dy) {
+      err += dx;
+      start.y += sy;
+    }
+  }
+}
+
+/**
+ * Find the span of each row a convex polygon covers, returning false if it
+ * covers none on screen
+ */
+static bool walk_polygon(const GPoint *points, int num_points, int *out_min_y, int *out_max_y) {
+  int min_x = points[0].x;
+  int max_x = points[0].x;
+  int min_y = points[0].y;
+  int max_y = points[0].y;
+  for (int i = 1; i < num_points; i++) {
+    min_x = (points[i].x < min_x) ? points[i].x : min_x;
+    max_x = (points[i].x > max_x) ? points[i].x : max_x;
+    min_y = (points[i].y < min_y) ? points[i].y : min_y;
+    max_y = (points[i].y > max_y) ? points[i].y : max_y;
+  }
+  if (max_x < s_clip.origin.x || min_x >= s_clip.origin.x + s_clip.size.w) {
+    // Entirely off screen
+    return false;
+  }
+  min_y = (min_y < 0) ? 0 : min_y;
+  max_y = (max_y >= s_clip.size.h) ? s_clip.size.h - 1 : max_y;
+  if (min_y > max_y) {
+    return false;
+  }
+
+  for (int y = min_y; y <= max_y; y++) {
+    s_span_left[y] = INT16_MAX;
+    s_span_right[y] = INT16_MIN;
+  }
+  for (int i = 0; i < num_points; i++) {
+    walk_edge(points[i], points[(i + 1) % num_points]);
+  }
+  *out_min_y = min_y;
+  *out_max_y = max_y;
+  return true;
+}
+
+/**
+ * Fill a convex polygon one row span at a time
+ */
+static void fill_polygon(const GPoint *points, int num_points, GColor color) {
+  int min_y, max_y;
+  if (!walk_polygon(points, num_points, &min_y, &max_y)) {
+    return;
+  }
+
+  for (int y = min_y; y <= max_y; y++) {
+    if (s_span_left[y] <= s_span_right[y]) {
+      fill_span(y, s_span_left[y], s_span_right[y], color);
+    }
+  }
+}
+
+/**
+ * Fill the face of a box on the x = origin.x + size.w side
+ */
+static void fill_right_face(Vec3 origin, GSize size, int z_height, GColor color) {
+  int x = origin.x + size.w;
+  int top_z = origin.z + z_height - 1;
+  set_depth_plane_x(x);
+  GPoint points[4] = {
+    isometric_project(Vec3(x, origin.y, origin.z)),
+    isometric_project(Vec3(x, origin.y + size.h, origin.z)),
+    isometric_project(Vec3(x, origin.y + size.h, top_z)),
+    isometric_project(Vec3(x, origin.y, top_z))
+  };
+  fill_polygon(points, 4, color);
+}
+
+/**
+ * Fill the face of a box on the y = origin.y + size.h side
+ */
+static void fill_left_face(Vec3 origin, GSize size, int z_height, GColor color) {
+  int y = origin.y + size.h;
+  int top_z = origin.z + z_height - 1;
+  set_depth_plane_y(y);
+  GPoint points[4] = {
+    isometric_project(Vec3(origin.x, y, origin.z)),
+    isometric_project(Vec3(origin.x + size.w, y, origin.z)),
+    isometric_project(Vec3(origin.x + size.w, y, top_z)),
+    isometric_project(Vec3(origin.x, y, top_z))
+  };
+  fill_polygon(points, 4, color);
+}
+
+static uint32_t hash_list() {
+  uint32_t hash = 2166136261u;
+  hash = hash_int(hash, s_list_start_enabled);
+  hash = hash_int(hash, s_list_start_offset.x);
+  hash = hash_int(hash, s_list_start_offset.y);
+  for (int i = 0; i < s_list_length; i++) {
+    ListCommand *command = &s_list[i];
+    const int values[] = {
+      command->type, command->flags, command->origin.x, command->origin.y, command->origin.z,
+      command->size.w, command->size.h, command->z_height, command->colors[0].argb,
+      command->colors[1].argb, command->colors[2].argb, command->colors[3].argb,
+      (int)(uintptr_t)command->data, command->data_hash
+    };
+    hash = hash_bytes(hash, (const uint8_t*)values, sizeof(values));
+  }
+  return hash;
+}
+
+static void replay_list() {
+  // Commands draw instead of recording while replayed
+  s_list_recording = false;
+  s_enabled = s_list_start_enabled;
+  s_projection_offset = s_list_start_offset;
+
+  for (int i = 0; i < s_list_length; i++) {
+    ListCommand *c = &s_list[i];
+    switch (c->type) {
+      case ListCommandSetEnabled:
+        s_enabled = c->flags & LIST_FLAG_A;
+        break;
+      case ListCommandSetProjectionOffset:
+        s_projection_offset = GPoint(c->origin.x, c->origin.y);
+        break;
+      case ListCommandDrawRect:
+        isometric_draw_rect(c->origin, c->size, c->colors[0]);
+        break;
+      case ListCommandFillRect:
+        isometric_fill_rect(c->origin, c->size, c->colors[0]);
+        break;
+      case ListCommandFillBoxShaded:
+        isometric_fill_box_shaded(c->origin, c->size, c->z_height, c->colors[0], c->colors[1], c->colors[2]);
+        break;
+      case ListCommandDrawBox:
+        isometric_draw_box(c->origin, c->size, c->z_height, c->colors[0], c->flags & LIST_FLAG_A);
+        break;
+      case ListCommandDrawPixel:
+        isometric_draw_pixel(c->origin, c->colors[0]);
+        break;
+      case ListCommandFillTexturedRect:
+        isometric_fill_textured_rect(c->origin, (GBitmap*)c->data);
+        break;
+      case ListCommandDrawBoxFaces:
+        isometric_draw_box_faces(c->origin, c->size, c->z_height, c->colors[0],
+          c->flags & LIST_FLAG_A, c->flags & LIST_FLAG_B, c->flags & LIST_FLAG_C);
+        break;
+      case ListCommandFillBoxFaces:
+        isometric_fill_box_faces(c->origin, c->size, c->z_height, c->colors[0],
+          c->flags & LIST_FLAG_A, c->flags & LIST_FLAG_B, c->flags & LIST_FLAG_C);
+        break;
+      case ListCommandStampBox:
+        isometric_stamp_box(c->origin, c->size, c->z_height, c->colors[0], c->colors[1], c->colors[2], c->colors[3]);
+        break;
+      case ListCommandDrawVoxelGrid:
+        isometric_draw_voxel_grid((IsometricVoxelGrid*)c->data, c->origin, c->colors[0]);
+        break;
+    }
+  }
+}
+
+static void copy_bitmap(GBitmap *dest, GBitmap *src) {
+  for (int y = 0; y < s_fb_size.h; y++) {
+    GBitmapDataRowInfo dest_info = gbitmap_get_data_row_info(dest, y);
+    GBitmapDataRowInfo src_info = gbitmap_get_data_row_info(src, y);
+#if defined(PBL_COLOR)
+    memcpy(&dest_info.data[dest_info.min_x], &src_info.data[dest_info.min_x], dest_info.max_x - dest_info.min_x + 1);
+#elif defined(PBL_BW)
+    memcpy(&dest_info.data[dest_info.min_x / 8], &src_info.data[dest_info.min_x / 8],
+      (dest_info.max_x / 8) - (dest_info.min_x / 8) + 1);
+#endif
+  }
+}
+
+static bool list_matches_prev() {
+  return s_list_length == s_list_prev_length
+    && s_list_start_enabled == s_list_prev_enabled
+    && gpoint_equal(&s_list_start_offset, &s_list_prev_offset)
+    && (s_list_length == 0 || memcmp(s_list, s_list_prev, s_list_length * sizeof(ListCommand)) == 0);
+}
+
+/**
+ * Draw the recorded list, or the copy of what it drew last time if it is the same
+ */
+static void finish_list() {
+  if (!s_list_recording) {
+    // Drawn directly after running out of memory
+    s_list_length = 0;
+    return;
+  }
+
+  uint32_t hash = hash_list();
+  if (s_list_cache_valid && hash == s_list_hash && list_matches_prev()) {
+    copy_bitmap(s_fb, s_list_cache);
+  } else {
+    replay_list();
+
+    if (!s_list_cache) {
+      s_list_cache = gbitmap_create_blank(s_fb_size, gbitmap_get_format(s_fb));
+      if (!s_list_cache) {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "Not enough memory for draw list cache, drawing every frame");
+      }
+    }
+    if (s_list_cache) {
+      copy_bitmap(s_list_cache, s_fb);
+      s_list_hash = hash;
+      s_list_cache_valid = true;
+
+      // Keep this list to compare against, recording the next into the old one
+      ListCommand *list = s_list_prev;
+      int capacity = s_list_prev_capacity;
+      s_list_prev = s_list;
+      s_list_prev_capacity = s_list_capacity;
+      s_list_prev_length = s_list_length;
+      s_list_prev_enabled = s_list_start_enabled;
+      s_list_prev_offset = s_list_start_offset;
+      s_list = list;
+      s_list_capacity = capacity;
+    }
+  }
+  s_list_recording = false;
+  s_list_length = 0;
+}
+
+/**
+ * Corners of the area covered by a filled isometric rectangle
+ */
+static void get_rect_outline(Vec3 origin, GSize size, GPoint *points) {
+  // Rows origin.y to origin.y + size.h - 1, and the row of pixels below them
+  int last_y = origin.y + size.h - 1;
+  GPoint back = isometric_project(Vec3(origin.x, origin.y, origin.z));
+  GPoint right = isometric_project(Vec3(origin.x + size.w, origin.y, origin.z));
+  GPoint front = isometric_project(Vec3(origin.x + size.w, last_y, origin.z - 1));
+  GPoint left = isometric_project(Vec3(origin.x, last_y, origin.z));
+  points[0] = back;
+  points[1] = right;
+  points[2] = GPoint(right.x, right.y + 1);
+  points[3] = front;
+  points[4] = GPoint(left.x, left.y + 1);
+  points[5] = left;
+}
+
+// Reads the color of pixel x of a texture row, in one of the supported formats
+typedef GColor (TexelReader)(const uint8_t *row, const GColor *palette, int x);
+
+static GColor read_texel_1bit(const uint8_t *row, const GColor *palette, int x) {
+  // Least significant bit first
+  return ((row[x / 8] >> (x % 8)) & 1) ? GColorWhite : GColorBlack;
+}
+
+static GColor read_texel_1bit_palette(const uint8_t *row, const GColor *palette, int x) {
+  // Palettized formats pack the first pixel in the most significant bits
+  return palette[(row[x / 8] >> (7 - (x % 8))) & 0x1];
+}
+
+static GColor read_texel_2bit_palette(const uint8_t *row, const GColor *palette, int x) {
+  return palette[(row[x / 4] >> (6 - (2 * (x % 4)))) & 0x3];
+}
+
+static GColor read_texel_4bit_palette(const uint8_t *row, const GColor *palette, int x) {
+  return palette[(row[x / 2] >> (4 - (4 * (x % 2)))) & 0xF];
+}
+
+static GColor read_texel_8bit(const uint8_t *row, const GColor *palette, int x) {
+  return (GColor) { .argb = row[x] };
+}
+
+static TexelReader* get_texel_reader(GBitmapFormat format) {
+  switch (format) {
+    case GBitmapFormat1Bit: return read_texel_1bit;
+    case GBitmapFormat1BitPalette: return read_texel_1bit_palette;
+    case GBitmapFormat2BitPalette: return read_texel_2bit_palette;
+    case GBitmapFormat4BitPalette: return read_texel_4bit_palette;
+    case GBitmapFormat8Bit: return read_texel_8bit;
+    default: return NULL;
+  }
+}
+
+/**
+ * Draw pixels x0 to x1 of row y from the texture. u and v are twice the texel
+ * coordinates at x0, and du and dv how much they change for each pixel along.
+ */
+static void texture_span(int y, int x0, int x1, int u, int v, int du, int dv,
+                         GSize tex_size, const uint8_t *tex_data, int bytes_per_row,
+                         const GColor *palette, TexelReader *read_texel) {
+  x0 = (x0 < s_rows[y].min_x) ? s_rows[y].min_x : x0;
+  x1 = (x1 > s_rows[y].max_x) ? s_rows[y].max_x : x1;
+
+  for (int x = x0; x <= x1; x++, u += du, v += dv) {
+    // Edge pixels can round to just outside the texture
+    int tex_x = u >> 1;
+    int tex_y = v >> 1;
+    tex_x = (tex_x < 0) ? 0 : ((tex_x >= tex_size.w) ? tex_size.w - 1 : tex_x);
+    tex_y = (tex_y < 0) ? 0 : ((tex_y >= tex_size.h) ? tex_size.h - 1 : tex_y);
+
+    GColor color = read_texel(&tex_data[tex_y * bytes_per_row], palette, tex_x);
+    if (color.a == 0) {
+      // Transparent
+      continue;
+    }
+    plot_pixel(x, y, get_pixel_color(x, y, color));
+  }
+}
+
 GBitmap* isometric_begin(GContext *ctx) {
   s_fb = graphics_capture_frame_buffer(ctx);
   s_fb_data = gbitmap_get_data(s_fb);
   s_fb_size = gbitmap_get_bounds(s_fb).size;
+#if defined(PBL_BW)
+  if (!s_dither_patterns_ready) {
+    build_dither_patterns();
+  }
+#endif
+
+  // Fetch every row once, and find what is drawable on all or any of them
+  int rows = (s_fb_size.h < MAX_ROWS) ? s_fb_size.h : MAX_ROWS;
+  int inner_min_x = 0, inner_max_x = s_fb_size.w - 1;
+  int outer_min_x = s_fb_size.w - 1, outer_max_x = 0;
+  for (int y = 0; y < rows; y++) {
+    s_rows[y] = gbitmap_get_data_row_info(s_fb, y);
+    inner_min_x = (s_rows[y].min_x > inner_min_x) ? s_rows[y].min_x : inner_min_x;
+    inner_max_x = (s_rows[y].max_x < inner_max_x) ? s_rows[y].max_x : inner_max_x;
+    outer_min_x = (s_rows[y].min_x < outer_min_x) ? s_rows[y].min_x : outer_min_x;
+    outer_max_x = (s_rows[y].max_x > outer_max_x) ? s_rows[y].max_x : outer_max_x;
+  }
+  s_clip = GRect(outer_min_x, 0, outer_max_x - outer_min_x + 1, rows);
+  s_clip_inner = GRect(inner_min_x, 0, inner_max_x - inner_min_x + 1, rows);
+
+  if (s_depth_enabled) {
+    if (!s_depth_buffer) {
+      s_depth_buffer = malloc(s_fb_size.w * s_fb_size.h);
+      if (!s_depth_buffer) {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "Not enough memory for depth buffer, drawing in order");
+        s_depth_enabled = false;
+      }
+    }
+    if (s_depth_buffer) {
+      memset(s_depth_buffer, 0, s_fb_size.w * s_fb_size.h);
+    }
+  }
+
+  if (s_list_enabled) {
+    s_list_recording = true;
+    s_list_length = 0;
+    s_list_start_enabled = s_enabled;
+    s_list_start_offset = s_projection_offset;
+  }
   return s_fb;  // Optionally further use the framebuffer GBitmap
 }
 
 void isometric_finish(GContext *ctx) {
   if (s_fb) {
+    if (s_list_enabled) {
+      finish_list();
+    }
     graphics_release_frame_buffer(ctx, s_fb);
     s_fb = NULL;
     s_fb_data = NULL;
@@ -66,13 +881,54 @@ void isometric_finish(GContext *ctx) {
 }
 
 void isometric_set_enabled(bool b) {
+  if (s_list_recording) {
+    record_command((ListCommand) { .type = ListCommandSetEnabled, .flags = b ? LIST_FLAG_A : 0 });
+  }
   s_enabled = b;
 }
 
 void isometric_set_projection_offset(GPoint offset) {
+  if (s_list_recording) {
+    record_command((ListCommand) { .type = ListCommandSetProjectionOffset, .origin = Vec3(offset.x, offset.y, 0) });
+  }
   s_projection_offset = offset;
 }
 
+void isometric_set_draw_list_enabled(bool enabled) {
+  s_list_enabled = enabled;
+  if (!enabled) {
+    free(s_list);
+    s_list = NULL;
+    s_list_length = 0;
+    s_list_capacity = 0;
+    free(s_list_prev);
+    s_list_prev = NULL;
+    s_list_prev_length = 0;
+    s_list_prev_capacity = 0;
+    if (s_list_cache) {
+      gbitmap_destroy(s_list_cache);
+      s_list_cache = NULL;
+    }
+    s_list_cache_valid = false;
+  }
+}
+
+void isometric_invalidate_draw_list() {
+  s_list_cache_valid = false;
+}
+
+void isometric_set_depth_buffer_enabled(bool enabled) {
+  s_depth_enabled = enabled;
+  if (!enabled && s_depth_buffer) {
+    free(s_depth_buffer);
+    s_depth_buffer = NULL;
+  }
+}
+
+void isometric_set_depth_scale(int shift) {
+  s_depth_shift = (shift < 0) ? 0 : shift;
+}
+
 GPoint isometric_project(Vec3 input) {
   GPoint result;
   if (s_enabled) {
@@ -86,6 +942,13 @@ GPoint isometric_project(Vec3 input) {
 }
 
 void isometric_draw_rect(Vec3 origin, GSize size, GColor color) {
+  if (s_list_recording
+      && record_command((ListCommand) { .type = ListCommandDrawRect, .origin = origin, .size = size, .colors = { color } })) {
+    return;
+  }
+
+  set_depth_plane_z(origin.z);
+
   // Top
   GPoint start = isometric_project(origin);
   GPoint finish = isometric_project(Vec3(origin.x + size.w, origin.y, origin.z));
@@ -108,53 +971,61 @@ void isometric_draw_rect(Vec3 origin, GSize size, GColor color) {
 }
 
 void isometric_fill_rect(Vec3 origin, GSize size, GColor color) {
-  int iterations = 2;
-#if defined(PBL_BW)
-  // Prevent vertical stipes when dithered gray
-  if (gcolor_equal(color, GColorDarkGray) || gcolor_equal(color, GColorLightGray)) {
-    iterations = 1;
+  if (s_list_recording
+      && record_command((ListCommand) { .type = ListCommandFillRect, .origin = origin, .size = size, .colors = { color } })) {
+    return;
   }
-#endif
-  for(int i = 0; i < iterations; i++) {
-    for(int y = origin.y; y < origin.y + size.h; y++) {
-      bresenham_line(
-        isometric_project(Vec3(origin.x, y, origin.z)), 
-        isometric_project(Vec3(origin.x + size.w, y, origin.z)),
-        color
-      );
-    }
-    origin.z--; // Draw twice to fill
+
+  if (size.w < 0 || size.h <= 0) {
+    return;
   }
+
+  set_depth_plane_z(origin.z);
+  GPoint points[6];
+  get_rect_outline(origin, size, points);
+  fill_polygon(points, 6, color);
 }
 
 void isometric_fill_box(Vec3 origin, GSize size, int z_height, GColor color) {
-  // Draw only front for speed when ISOMETRIC_OPTIMIZE_FILL_BOX is defined
-  int z = 0;
-  for(z = origin.z; z < origin.z + z_height; z++) {
-#if defined(ISOMETRIC_OPTIMIZE_FILL_BOX)
-    // Right
-    GPoint start = isometric_project(Vec3(origin.x + size.w, origin.y, z));
-    GPoint finish = isometric_project(Vec3(origin.x + size.w, origin.y + size.h, z));
-    bresenham_line(start, finish, color);
+  isometric_fill_box_shaded(origin, size, z_height, color, color, color);
+}
 
-    // Bottom
-    start = isometric_project(Vec3(origin.x, origin.y + size.h, z));
-    finish = isometric_project(Vec3(origin.x + size.w, origin.y + size.h, z));
-    bresenham_line(start, finish, color);
-#else
-    isometric_draw_rect(Vec3(origin.x, origin.y, z), size, color);
-#endif
+void isometric_fill_box_shaded(Vec3 origin, GSize size, int z_height, GColor top, GColor right, GColor left) {
+  if (s_list_recording && record_command((ListCommand) {
+    .type = ListCommandFillBoxShaded, .origin = origin, .size = size, .z_height = z_height,
+    .colors = { top, right, left }
+  })) {
+    return;
   }
 
-  // Fill in top
-  isometric_fill_rect(Vec3(origin.x, origin.y, (z_height > 0) ? z - 1 : z), size, color);
+  if (z_height <= 0) {
+    // Flat, only the top
+    isometric_fill_rect(origin, size, top);
+    return;
+  }
+
+  // Only the three faces that can be seen, each filled once
+  fill_right_face(origin, size, z_height, right);
+  fill_left_face(origin, size, z_height, left);
+
+  // Top last so it owns the edges it shares with the sides
+  isometric_fill_rect(Vec3(origin.x, origin.y, origin.z + z_height - 1), size, top);
 }
 
 void isometric_draw_box(Vec3 origin, GSize size, int z_height, GColor color, bool all_edges) {
+  if (s_list_recording && record_command((ListCommand) {
+    .type = ListCommandDrawBox, .origin = origin, .size = size, .z_height = z_height,
+    .colors = { color }, .flags = all_edges ? LIST_FLAG_A : 0
+  })) {
+    return;
+  }
+
   // Bottom
+  set_depth_plane_x(origin.x + size.w);
   GPoint start = isometric_project(Vec3(origin.x + size.w, origin.y, origin.z));
   GPoint finish = isometric_project(Vec3(origin.x + size.w, origin.y + size.h, origin.z));
   bresenham_line(start, finish, color);
+  set_depth_plane_y(origin.y + size.h);
   start = isometric_project(Vec3(origin.x, origin.y + size.h, origin.z));
   finish = isometric_project(Vec3(origin.x + size.w, origin.y + size.h, origin.z));
   bresenham_line(start, finish, color);
@@ -163,6 +1034,7 @@ void isometric_draw_box(Vec3 origin, GSize size, int z_height, GColor color, boo
   isometric_draw_rect(Vec3(origin.x, origin.y, origin.z + z_height), size, color);
 
   // Sides
+  set_depth_plane_y(origin.y + size.h);
   bresenham_line(
     isometric_project(Vec3(origin.x, origin.y + size.h, origin.z)), 
     isometric_project(Vec3(origin.x, origin.y + size.h, origin.z + z_height)),
@@ -173,6 +1045,7 @@ void isometric_draw_box(Vec3 origin, GSize size, int z_height, GColor color, boo
     isometric_project(Vec3(origin.x + size.w, origin.y + size.h, origin.z + z_height)),
     color
   );
+  set_depth_plane_x(origin.x + size.w);
   bresenham_line(
     isometric_project(Vec3(origin.x + size.w, origin.y, origin.z)), 
     isometric_project(Vec3(origin.x + size.w, origin.y, origin.z + z_height)),
@@ -181,6 +1054,7 @@ void isometric_draw_box(Vec3 origin, GSize size, int z_height, GColor color, boo
 
   if (all_edges) {
     // Vertical line at top
+    set_depth_plane_x(origin.x);
     bresenham_line(
       isometric_project(Vec3(origin.x, origin.y, origin.z)), 
       isometric_project(Vec3(origin.x, origin.y, origin.z + z_height)),
@@ -188,6 +1062,7 @@ void isometric_draw_box(Vec3 origin, GSize size, int z_height, GColor color, boo
     );
     
     // Left bottom edge
+    set_depth_plane_z(origin.z);
     bresenham_line(
       isometric_project(Vec3(origin.x, origin.y, origin.z)), 
       isometric_project(Vec3(origin.x, origin.y + size.h, origin.z)),
@@ -203,34 +1078,90 @@ void isometric_draw_box(Vec3 origin, GSize size, int z_height, GColor color, boo
 }
 
 void isometric_draw_pixel(Vec3 point, GColor color) {
-  s_info = gbitmap_get_data_row_info(s_fb, point.y);
+  if (s_list_recording
+      && record_command((ListCommand) { .type = ListCommandDrawPixel, .origin = point, .colors = { color } })) {
+    return;
+  }
+
+  set_depth_plane_z(point.z);
   set_pixel(isometric_project(point), color);
 }
 
 void isometric_fill_textured_rect(Vec3 origin, GBitmap *texture) {
-  // Map all bitmap pixels
-  uint8_t *tex_data = gbitmap_get_data(texture);
-  GSize tex_size = gbitmap_get_bounds(texture).size;
-  uint8_t bytes_per_row = gbitmap_get_bytes_per_row(texture);
-  
-  for(int z = origin.z; z < origin.z + 2; z++) {
-    for(int y = 0; y < tex_size.h; y++) {
-      s_info = gbitmap_get_data_row_info(s_fb, origin.y);
-      for(int x = 0; x < tex_size.w; x++) {
-        uint8_t value = tex_data[(y * bytes_per_row) + x];
-        set_pixel(isometric_project(Vec3(origin.x + x, origin.y + y, z)), (GColor)value);
-      }
+  if (s_list_recording) {
+    GSize size = gbitmap_get_bounds(texture).size;
+    uint32_t hash = hash_bytes(2166136261u, gbitmap_get_data(texture), size.h * gbitmap_get_bytes_per_row(texture));
+    if (record_command((ListCommand) {
+      .type = ListCommandFillTexturedRect, .origin = origin, .data = texture, .data_hash = hash
+    })) {
+      return;
+    }
+  }
+
+  TexelReader *read_texel = get_texel_reader(gbitmap_get_format(texture));
+  if (!read_texel) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Unsupported texture format!");
+    return;
+  }
+
+  GRect tex_bounds = gbitmap_get_bounds(texture);
+  int bytes_per_row = gbitmap_get_bytes_per_row(texture);
+  const uint8_t *tex_data = gbitmap_get_data(texture) + (tex_bounds.origin.y * bytes_per_row);
+  const GColor *palette = gbitmap_get_palette(texture);
+  if (tex_bounds.origin.x != 0) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Texture bounds must start at x = 0!");
+    return;
+  }
+
+  set_depth_plane_z(origin.z);
+  GPoint points[6];
+  get_rect_outline(origin, tex_bounds.size, points);
+  int min_y, max_y;
+  if (!walk_polygon(points, 6, &min_y, &max_y)) {
+    return;
+  }
+
+  for (int y = min_y; y <= max_y; y++) {
+    int x0 = s_span_left[y];
+    if (x0 > s_span_right[y]) {
+      continue;
+    }
+
+    // Undo the projection at the start of each span, then step along it
+    int u, v, du, dv;
+    if (s_enabled) {
+      int sum = 2 * (y - s_projection_offset.y + origin.z);  // x + y
+      int difference = x0 - s_projection_offset.x;           // x - y
+      u = sum + difference - (2 * origin.x);
+      v = sum - difference - (2 * origin.y);
+      du = 1;
+      dv = -1;
+    } else {
+      u = 2 * (x0 - origin.x);
+      v = 2 * (y - origin.y);
+      du = 2;
+      dv = 0;
     }
+    texture_span(y, x0, s_span_right[y], u, v, du, dv,
+      tex_bounds.size, tex_data, bytes_per_row, palette, read_texel);
   }
 }
 
 void isometric_draw_box_faces(Vec3 origin, GSize size, int z_height, GColor color, bool top, bool right, bool left) {
+  if (s_list_recording && record_command((ListCommand) {
+    .type = ListCommandDrawBoxFaces, .origin = origin, .size = size, .z_height = z_height, .colors = { color },
+    .flags = (top ? LIST_FLAG_A : 0) | (right ? LIST_FLAG_B : 0) | (left ? LIST_FLAG_C : 0)
+  })) {
+    return;
+  }
+
   if (top) {
     isometric_draw_rect(Vec3(origin.x, origin.y, origin.z + z_height), size, color);
   }
 
   if (right) {
     // Bottom
+    set_depth_plane_x(origin.x + size.w);
     GPoint start = isometric_project(Vec3(origin.x + size.w, origin.y, origin.z));
     GPoint finish = isometric_project(Vec3(origin.x + size.w, origin.y + size.h, origin.z));
     bresenham_line(start, finish, color);
@@ -253,6 +1184,7 @@ void isometric_draw_box_faces(Vec3 origin, GSize size, int z_height, GColor colo
 
   if (left) {
     // Bottom
+    set_depth_plane_y(origin.y + size.h);
     GPoint start = isometric_project(Vec3(origin.x, origin.y + size.h, origin.z));
     GPoint finish = isometric_project(Vec3(origin.x + size.w, origin.y + size.h, origin.z));
     bresenham_line(start, finish, color);
@@ -275,25 +1207,297 @@ void isometric_draw_box_faces(Vec3 origin, GSize size, int z_height, GColor colo
 }
 
 void isometric_fill_box_faces(Vec3 origin, GSize size, int z_height, GColor color, bool top, bool right, bool left) {
+  if (s_list_recording && record_command((ListCommand) {
+    .type = ListCommandFillBoxFaces, .origin = origin, .size = size, .z_height = z_height, .colors = { color },
+    .flags = (top ? LIST_FLAG_A : 0) | (right ? LIST_FLAG_B : 0) | (left ? LIST_FLAG_C : 0)
+  })) {
+    return;
+  }
+
   if (top) {
     isometric_fill_rect(Vec3(origin.x, origin.y, origin.z + z_height), size, color);
   }
 
+  if (z_height <= 0) {
+    return;
+  }
+
   if (right) {
-    for(int z = origin.z; z < origin.z + z_height; z++) {
-      // Right
-      GPoint start = isometric_project(Vec3(origin.x + size.w, origin.y, z));
-      GPoint finish = isometric_project(Vec3(origin.x + size.w, origin.y + size.h, z));
-      bresenham_line(start, finish, color);
-    }
+    fill_right_face(origin, size, z_height, color);
   }
 
   if (left) {
-    for(int z = origin.z; z < origin.z + z_height; z++) {
-      // Bottom
-      GPoint start = isometric_project(Vec3(origin.x, origin.y + size.h, z));
-      GPoint finish = isometric_project(Vec3(origin.x + size.w, origin.y + size.h, z));
-      bresenham_line(start, finish, color);
+    fill_left_face(origin, size, z_height, color);
+  }
+}
+
+static void draw_faces(Vec3 origin, GSize size, int z_height, GColor top, GColor right, GColor left, GColor outline, uint8_t faces) {
+  if (z_height > 0) {
+    if (faces & FACE_RIGHT) {
+      fill_right_face(origin, size, z_height, right);
+    }
+    if (faces & FACE_LEFT) {
+      fill_left_face(origin, size, z_height, left);
+    }
+  }
+  if (faces & FACE_TOP) {
+    isometric_fill_rect(Vec3(origin.x, origin.y, origin.z + ((z_height > 0) ? z_height - 1 : 0)), size, top);
+  }
+  if (!gcolor_equal(outline, GColorClear)) {
+    isometric_draw_box_faces(origin, size, z_height, outline,
+      faces & FACE_TOP, faces & FACE_RIGHT, faces & FACE_LEFT);
+  }
+}
+
+static uint32_t hash_stamp_key(const StampKey *key) {
+  uint32_t hash = 2166136261u;
+  const int values[] = {
+    key->size.w, key->size.h, key->z_height, key->top.argb, key->right.argb, key->left.argb,
+    key->outline.argb, key->faces, key->x_parity, key->y_parity
+  };
+  for (unsigned int i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+    hash = (hash ^ (uint32_t)values[i]) * 16777619u;
+  }
+  return hash;
+}
+
+static bool stamp_keys_equal(const StampKey *a, const StampKey *b) {
+  return a->size.w == b->size.w && a->size.h == b->size.h && a->z_height == b->z_height
+    && gcolor_equal(a->top, b->top) && gcolor_equal(a->right, b->right)
+    && gcolor_equal(a->left, b->left) && gcolor_equal(a->outline, b->outline)
+    && a->faces == b->faces && a->x_parity == b->x_parity && a->y_parity == b->y_parity;
+}
+
+static void free_stamp(Stamp *stamp) {
+  if (stamp->row_starts) {
+    free(stamp->row_starts);
+    stamp->row_starts = NULL;
+    stamp->spans = NULL;
+  }
+}
+
+static bool record_stamp(Stamp *stamp, Vec3 origin, GSize size, int z_height, GColor top, GColor right, GColor left, GColor outline, uint8_t faces) {
+  // Bounds of every corner, relative to the projected origin
+  GPoint anchor = isometric_project(origin);
+  int min_x = anchor.x, max_x = anchor.x, min_y = anchor.y, max_y = anchor.y;
+  for (int i = 1; i < 8; i++) {
+    GPoint corner = isometric_project(Vec3(
+      origin.x + ((i & 1) ? size.w : 0),
+      origin.y + ((i & 2) ? size.h : 0),
+      origin.z + ((i & 4) ? z_height : 0)));
+    min_x = (corner.x < min_x) ? corner.x : min_x;
+    max_x = (corner.x > max_x) ? corner.x : max_x;
+    min_y = (corner.y < min_y) ? corner.y : min_y;
+    max_y = (corner.y > max_y) ? corner.y : max_y;
+  }
+  int num_rows = max_y - min_y + 2;
+  if (num_rows > MAX_ROWS) {
+    return false;
+  }
+
+  s_record_spans = malloc(MAX_STAMP_SPANS * sizeof(StampSpan));
+  s_record_rows = malloc(MAX_STAMP_SPANS * sizeof(uint16_t));
+  if (!s_record_spans || !s_record_rows) {
+    free(s_record_spans);
+    free(s_record_rows);
+    s_record_spans = NULL;
+    s_record_rows = NULL;
+    return false;
+  }
+  s_num_record_spans = 0;
+  s_record_overflow = false;
+
+  // Draw with the top left of the box at 0, 0
+  GPoint projection_offset = s_projection_offset;
+  GRect clip = s_clip;
+  GRect clip_inner = s_clip_inner;
+  s_projection_offset.x -= min_x;
+  s_projection_offset.y -= min_y;
+  s_clip = GRect(0, 0, max_x - min_x + 2, num_rows);
+  s_clip_inner = s_clip;
+  draw_faces(origin, size, z_height, top, right, left, outline, faces);
+  s_projection_offset = projection_offset;
+  s_clip = clip;
+  s_clip_inner = clip_inner;
+
+  bool success = !s_record_overflow;
+  if (success) {
+    // Group spans by row, keeping the order they were drawn in
+    stamp->row_starts = malloc(((num_rows + 1) * sizeof(uint16_t)) + (s_num_record_spans * sizeof(StampSpan)));
+    success = (stamp->row_starts != NULL);
+  }
+  if (success) {
+    stamp->spans = (StampSpan*)&stamp->row_starts[num_rows + 1];
+    stamp->width = max_x - min_x + 2;
+    stamp->num_rows = num_rows;
+    stamp->offset = GPoint(min_x - anchor.x, min_y - anchor.y);
+
+    memset(stamp->row_starts, 0, (num_rows + 1) * sizeof(uint16_t));
+    for (int i = 0; i < s_num_record_spans; i++) {
+      stamp->row_starts[s_record_rows[i] + 1]++;
+    }
+    for (int row = 0; row < num_rows; row++) {
+      stamp->row_starts[row + 1] += stamp->row_starts[row];
+    }
+    for (int i = 0; i < s_num_record_spans; i++) {
+      // Use the start of each row as its write position, then put it back
+      stamp->spans[stamp->row_starts[s_record_rows[i]]++] = s_record_spans[i];
+    }
+    for (int row = num_rows; row > 0; row--) {
+      stamp->row_starts[row] = stamp->row_starts[row - 1];
+    }
+    stamp->row_starts[0] = 0;
+  }
+
+  free(s_record_spans);
+  free(s_record_rows);
+  s_record_spans = NULL;
+  s_record_rows = NULL;
+  return success;
+}
+
+static void stamp_faces(Vec3 origin, GSize size, int z_height, GColor top, GColor right, GColor left, GColor outline, uint8_t faces) {
+  // Halving rounds towards zero, so boxes across an axis are a different shape
+  bool crosses_axis = (origin.x < 0 && origin.x + size.w > 0) || (origin.y < 0 && origin.y + size.h > 0);
+  if (!s_enabled || s_record_spans || crosses_axis || s_depth_buffer) {
+    // Stamps are only recorded in isometric projection, and hold no depth
+    draw_faces(origin, size, z_height, top, right, left, outline, faces);
+    return;
+  }
+
+  GPoint anchor = isometric_project(origin);
+
+  // The shape changes with how the projection halves odd coordinates
+  StampKey key = {
+    .size = size,
+    .z_height = z_height,
+    .top = top,
+    .right = right,
+    .left = left,
+    .outline = outline,
+    .faces = faces,
+    .x_parity = origin.x % 2,
+    .y_parity = origin.y % 2
+  };
+  uint32_t hash = hash_stamp_key(&key);
+  s_stamp_clock++;
+
+  Stamp *stamp = NULL;
+  Stamp *oldest = &s_stamps[0];
+  for (int i = 0; i < ISOMETRIC_MAX_STAMPS; i++) {
+    Stamp *candidate = &s_stamps[i];
+    if (candidate->row_starts && candidate->hash == hash && stamp_keys_equal(&candidate->key, &key)) {
+      stamp = candidate;
+      break;
+    }
+    if (!candidate->row_starts || candidate->last_used < oldest->last_used) {
+      oldest = candidate;
+    }
+  }
+
+  if (!stamp) {
+    // Replace the least recently used
+    free_stamp(oldest);
+    if (!record_stamp(oldest, origin, size, z_height, top, right, left, outline, faces)) {
+      draw_faces(origin, size, z_height, top, right, left, outline, faces);
+      return;
+    }
+    stamp = oldest;
+    stamp->key = key;
+    stamp->hash = hash;
+  }
+  stamp->last_used = s_stamp_clock;
+
+  int x = anchor.x + stamp->offset.x;
+  int y = anchor.y + stamp->offset.y;
+  int first_row = (y < 0) ? -y : 0;
+  int last_row = (y + stamp->num_rows > s_clip.size.h) ? s_clip.size.h - y : stamp->num_rows;
+  if (x + stamp->width <= s_clip.origin.x || x >= s_clip.origin.x + s_clip.size.w) {
+    // Entirely off screen
+    return;
+  }
+  for (int row = first_row; row < last_row; row++) {
+    for (int i = stamp->row_starts[row]; i < stamp->row_starts[row + 1]; i++) {
+      StampSpan *span = &stamp->spans[i];
+      fill_span(y + row, x + span->x0, x + span->x1, span->color);
+    }
+  }
+}
+
+void isometric_stamp_box(Vec3 origin, GSize size, int z_height, GColor top, GColor right, GColor left, GColor outline) {
+  if (s_list_recording && record_command((ListCommand) {
+    .type = ListCommandStampBox, .origin = origin, .size = size, .z_height = z_height,
+    .colors = { top, right, left, outline }
+  })) {
+    return;
+  }
+
+  stamp_faces(origin, size, z_height, top, right, left, outline, FACE_ALL);
+}
+
+void isometric_clear_stamps() {
+  for (int i = 0; i < ISOMETRIC_MAX_STAMPS; i++) {
+    free_stamp(&s_stamps[i]);
+  }
+}
+
+static bool is_voxel_empty(IsometricVoxelGrid *grid, int x, int y, int z) {
+  if (x >= grid->width || y >= grid->height || z >= grid->depth) {
+    // Nothing in front beyond the edge of the grid
+    return true;
+  }
+  return gcolor_equal(grid->voxels[(((z * grid->height) + y) * grid->width) + x], GColorClear);
+}
+
+void isometric_draw_voxel_grid(IsometricVoxelGrid *grid, Vec3 origin, GColor outline_color) {
+  if (s_list_recording) {
+    uint32_t hash = hash_int(2166136261u, grid->voxel_size);
+    hash = hash_bytes(hash, (const uint8_t*)grid->voxels, grid->width * grid->height * grid->depth * sizeof(GColor));
+    if (record_command((ListCommand) {
+      .type = ListCommandDrawVoxelGrid, .origin = origin, .size = GSize(grid->width, grid->height),
+      .z_height = grid->depth, .colors = { outline_color }, .data = grid, .data_hash = hash
+    })) {
+      return;
+    }
+  }
+
+  const int size = grid->voxel_size;
+
+  // The voxel one step nearer on every axis projects exactly on top of this
+  // one, unless odd coordinates are rounded differently when projected
+  const bool exact = s_enabled && (size % 2 == 0) && (origin.x % 2 == 0) && (origin.y % 2 == 0);
+
+  // Back to front
+  GColor *voxel = grid->voxels;
+  for (int z = 0; z < grid->depth; z++) {
+    for (int y = 0; y < grid->height; y++) {
+      for (int x = 0; x < grid->width; x++, voxel++) {
+        if (gcolor_equal(*voxel, GColorClear)) {
+          continue;
+        }
+
+        if (exact && !is_voxel_empty(grid, x + 1, y + 1, z + 1)) {
+          // Completely hidden
+          continue;
+        }
+
+        bool top = is_voxel_empty(grid, x, y, z + 1);
+        bool right = is_voxel_empty(grid, x + 1, y, z);
+        bool left = is_voxel_empty(grid, x, y + 1, z);
+        if (!top && !right && !left) {
+          // Surrounded
+          continue;
+        }
+
+        Vec3 position = Vec3(origin.x + (x * size), origin.y + (y * size), origin.z + (z * size));
+        uint8_t faces = (top ? FACE_TOP : 0) | (right ? FACE_RIGHT : 0) | (left ? FACE_LEFT : 0);
+        if (exact) {
+          // Every voxel projects alike, so identical ones are stamped from a recording of the first
+          stamp_faces(position, GSize(size, size), size, *voxel, *voxel, *voxel, outline_color, faces);
+        } else {
+          draw_faces(position, GSize(size, size), size, *voxel, *voxel, *voxel, outline_color, faces);
+        }
+      }
     }
   }
 }
@@ -33,6 +33,10 @@ static void update_proc(Layer *layer, GContext *ctx) {
   // Draw box with all edges
   isometric_draw_box(Vec3(0, 25, 0), GSize(16, 16), 16, GColorBlack, true);
 
+  // Draw box with a color per face
+  isometric_fill_box_shaded(Vec3(50, 0, 0), GSize(16, 16), 16,
+    GColorWhite, PBL_IF_COLOR_ELSE(GColorRed, GColorLightGray), GColorBlack);
+
   // Release framebuffer
   isometric_finish(ctx);
 }
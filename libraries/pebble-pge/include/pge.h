@@ -21,6 +21,25 @@
 // Number of seconds between framerate calculations
 #define PGE_FRAMERATE_INTERVAL_S 1
 
+// Default and maximum logic tick rate
+#define PGE_DEFAULT_FRAMERATE 30
+#define PGE_MAX_FRAMERATE 30
+
+// Most logic ticks run back-to-back to catch up before the backlog is dropped
+#define PGE_MAX_FRAME_SKIP 5
+
+// Separate damaged regions tracked before they are merged into one
+#define PGE_MAX_DIRTY_RECTS 8
+
+// Default time without activity before the power policy applies
+#define PGE_DEFAULT_IDLE_TIMEOUT_MS 2000
+
+// Number of recent frames kept by the profiler
+#define PGE_PROFILER_SAMPLES 32
+
+// Button events buffered between logic ticks before the oldest are dropped
+#define PGE_INPUT_QUEUE_SIZE 16
+
 /********************************** Engine ***********************************/
 
 // Function for user to place their per-frame game logic
@@ -32,6 +51,69 @@ typedef void (PGERenderHandler)(GContext *ctx);
 // Function for user to implement button clicks
 typedef void (PGEClickHandler)(int button_id, bool long_click);
 
+// What the engine does once the game is idle
+typedef enum {
+  PGEPowerModeAlwaysOn = 0,  // Keep ticking at the set framerate (default)
+  PGEPowerModeLowRate,       // Drop to idle_framerate
+  PGEPowerModePause          // Stop ticking until woken
+} PGEPowerMode;
+
+// How the engine saves power when nothing is happening
+typedef struct {
+  PGEPowerMode mode;   // What to do when idle
+  int idle_framerate;  // Tick rate while idle in PGEPowerModeLowRate
+  int idle_after_ms;   // Time without activity before going idle
+} PGEPowerPolicy;
+
+// Kinds of buffered button event
+typedef enum {
+  PGEInputEventTypePress = 0,
+  PGEInputEventTypeRelease
+} PGEInputEventType;
+
+// A button press or release, in the order they happened
+typedef struct {
+  ButtonId button;
+  PGEInputEventType type;
+  uint32_t time_ms;  // Time of the event, comparable with pge_get_time_ms()
+} PGEInputEvent;
+
+// Parts of a frame timed by the profiler
+typedef enum {
+  PGEProfilerPhaseLogic = 0,    // Logic ticks run for the frame
+  PGEProfilerPhaseRender,       // The PGERenderHandler, and backgrounds drawn by the system
+  PGEProfilerPhaseFramebuffer,  // Framebuffer capture, restore and release (0 without dirty rects)
+  PGEProfilerPhaseFrame,        // All of the above
+
+  PGEProfilerPhaseCount
+} PGEProfilerPhase;
+
+// Where the profiler reports its results, can be combined
+typedef enum {
+  PGEProfilerOutputNone = 0,
+  PGEProfilerOutputHUD = 1 << 0,  // Drawn over the top-left of each frame
+  PGEProfilerOutputLog = 1 << 1   // APP_LOG once every PGE_PROFILER_SAMPLES frames
+} PGEProfilerOutput;
+
+// Summary of one phase over the recent frames, in milliseconds
+typedef struct {
+  int min_ms;
+  int avg_ms;
+  int p95_ms;
+  int max_ms;
+} PGEProfilerSummary;
+
+// Per-frame timing statistics, in milliseconds
+typedef struct {
+  int budget_ms;       // Time available per tick at the current framerate
+  int last_logic_ms;   // Time spent in logic ticks leading to the last frame, 0 if none ran
+  int last_render_ms;  // Time spent in the last render
+  int last_frame_ms;   // Logic plus render time of the last frame
+  int max_frame_ms;    // Worst frame time since the last reset
+  int overruns;        // Frames that took longer than budget_ms
+  int skipped_frames;  // Renders dropped so logic could keep up
+} PGEFrameStats;
+
 // Implement app setup here
 void pge_init();
 
@@ -56,7 +138,37 @@ void pge_finish();
 bool pge_get_button_state(ButtonId button);
 
 /**
- * Set the desired framerate (0 - 30)
+ * Take the oldest buffered button event, if any.
+ * Returns false once all events have been taken.
+ *
+ * Press and release events are buffered as they happen, so taps shorter than
+ * a logic tick are not lost. Drain them in the PGELogicHandler:
+ *
+ *   PGEInputEvent event;
+ *   while(pge_input_poll(&event)) { ... }
+ */
+bool pge_input_poll(PGEInputEvent *event);
+
+/**
+ * Discard all buffered button events
+ */
+void pge_input_clear();
+
+/**
+ * Get how long a button has been held down in milliseconds, or 0 if it is up
+ */
+int pge_get_button_held_ms(ButtonId button);
+
+/**
+ * Get the engine's millisecond clock. Wraps, so only use differences.
+ */
+uint32_t pge_get_time_ms();
+
+/**
+ * Set the desired logic tick rate (1 - 30) in ticks per second.
+ *
+ * Logic runs at this fixed rate regardless of how long rendering takes.
+ * If a frame overruns, logic catches up and renders are skipped instead.
  */
 void pge_set_framerate(int new_rate);
 
@@ -71,7 +183,7 @@ void pge_set_background(int bg_resource_id);
 void pge_set_background_color(GColor color);
 
 /**
- * Manually request a new frame to be rendered
+ * Manually request a new frame: run one logic tick and render it
  */
 void pge_manual_advance();
 
@@ -85,6 +197,114 @@ Window* pge_get_window();
  */
 int pge_get_average_framerate();
 
+/**
+ * Enable or disable dirty rectangle rendering (disabled by default).
+ *
+ * When enabled, the screen is not cleared each frame. Only regions marked with
+ * pge_mark_dirty_rect() (PGESprites do this automatically when they change)
+ * are restored to the background and redrawn.
+ */
+void pge_set_dirty_rects_enabled(bool enabled);
+
+/**
+ * Get whether dirty rectangle rendering is enabled
+ */
+bool pge_get_dirty_rects_enabled();
+
+/**
+ * Mark a region of the screen as needing to be redrawn in the next frame.
+ * Always counts as activity for the power policy, but the region is only
+ * recorded if dirty rectangle rendering is enabled.
+ */
+void pge_mark_dirty_rect(GRect rect);
+
+/**
+ * Mark the whole screen as needing to be redrawn in the next frame
+ */
+void pge_mark_all_dirty();
+
+/**
+ * Get the regions being redrawn in the current frame, for use in the
+ * PGERenderHandler to skip drawing anything outside them.
+ * Returns the number of rects.
+ */
+int pge_get_dirty_rects(const GRect **rects);
+
+/**
+ * Query whether a region overlaps any region being redrawn in the current frame.
+ * Always true when dirty rectangle rendering is not enabled.
+ */
+bool pge_is_rect_dirty(GRect rect);
+
+/**
+ * Get timing statistics for recent frames
+ */
+PGEFrameStats pge_get_frame_stats();
+
+/**
+ * Reset the accumulated frame statistics
+ */
+void pge_reset_frame_stats();
+
+/**
+ * Enable or disable the frame profiler (disabled by default), and choose where
+ * it reports. Enabling it clears any previous samples.
+ */
+void pge_profiler_set_enabled(bool enabled, PGEProfilerOutput output);
+
+/**
+ * Get whether the frame profiler is enabled
+ */
+bool pge_profiler_get_enabled();
+
+/**
+ * Get the number of frames currently held by the profiler,
+ * up to PGE_PROFILER_SAMPLES
+ */
+int pge_profiler_get_num_samples();
+
+/**
+ * Get the min, average, 95th percentile and max time of a phase over the
+ * frames held by the profiler
+ */
+PGEProfilerSummary pge_profiler_get_summary(PGEProfilerPhase phase);
+
+/**
+ * Discard the frames held by the profiler
+ */
+void pge_profiler_reset();
+
+/**
+ * Set how the engine saves power when the game is idle.
+ *
+ * The game is idle once no activity has been reported for idle_after_ms and
+ * no buttons are held. Activity is reported by pge_report_activity() and
+ * whenever a region is marked with pge_mark_dirty_rect() (including by
+ * PGESprites). A button press or pge_wake() returns to the full framerate.
+ */
+void pge_set_power_policy(PGEPowerPolicy policy);
+
+/**
+ * Get the current power policy
+ */
+PGEPowerPolicy pge_get_power_policy();
+
+/**
+ * Report from the PGELogicHandler that the game state changed this tick
+ */
+void pge_report_activity();
+
+/**
+ * Leave the idle state and return to the full framerate, such as when an
+ * event outside the engine (tick, message, etc.) changes the game state
+ */
+void pge_wake();
+
+/**
+ * Get whether the engine has gone idle under the power policy
+ */
+bool pge_is_idle();
+
 /**
  * Pause rendering
  */
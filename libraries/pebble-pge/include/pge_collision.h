@@ -2,6 +2,13 @@
 
 #include <pebble.h>
 #include "pge.h"  // GLine
+#include "pge_sprite.h"
+
+// Most grid cells a body can cover before it is tested against everything
+#define PGE_COLLISION_MAX_CELLS_PER_BODY 4
+
+// Time of impact at the end of a movement, fixed point
+#define PGE_COLLISION_TIME_MAX 1024
 
 // Convenience types
 typedef struct GLine {
@@ -17,3 +24,91 @@ bool pge_collision_line_line(GLine *line_a, GLine *line_b);
 
 bool pge_collision_point_rectangle(GPoint *point, GRect *rect);
 
+/**
+ * Test whether two rectangles moving by velocity_a and velocity_b over a frame
+ * touch at any point during it, so fast objects can't pass through each other.
+ * On a hit, time_of_impact is set to how far through the movement they first
+ * touch, from 0 (already touching) to PGE_COLLISION_TIME_MAX.
+ *
+ * Note: time_of_impact can be NULL if not needed
+ */
+bool pge_collision_swept_rectangle_rectangle(GRect *rect_a, GPoint velocity_a, GRect *rect_b, GPoint velocity_b, int32_t *time_of_impact);
+
+/**
+ * Test whether a line segment hits a rectangle, setting time_of_impact to how
+ * far along it from p1 to p2 it first touches, from 0 to PGE_COLLISION_TIME_MAX.
+ *
+ * Note: time_of_impact can be NULL if not needed
+ */
+bool pge_collision_line_rectangle_swept(GLine *line, GRect *rect, int32_t *time_of_impact);
+
+/****************************** Collision World *******************************/
+
+// Called once for each overlapping pair, with the contexts given when added
+typedef void (PGECollisionPairHandler)(void *context_a, void *context_b);
+
+// Sprite registered with a PGECollisionWorld
+typedef struct {
+  PGESprite *sprite;
+  void *context;
+  GRect aabb;     // Cached when the world is updated
+  uint8_t group;
+  bool active;
+  bool bucketed;  // In the grid since the last update
+} PGECollisionBody;
+
+// Broadphase that buckets bodies into a uniform grid of cells
+typedef struct {
+  GRect bounds;
+  int cell_size;
+  int columns;
+  int rows;
+  PGECollisionBody *bodies;
+  uint16_t max_bodies;
+  uint16_t num_used;        // Bodies ever used, free ones below are in free_ids
+  uint16_t *free_ids;
+  uint16_t num_free;
+  uint16_t *cell_starts;    // Start of each cell's run in cell_entries
+  uint16_t *cell_cursors;
+  uint16_t *cell_entries;
+  uint16_t *large_ids;      // Bodies covering too many cells to bucket
+  uint16_t num_large;
+} PGECollisionWorld;
+
+/**
+ * Create a collision world covering bounds, for up to max_bodies sprites.
+ * Use a cell_size about the size of the sprites, or 0 to use the
+ * pge_grid tile size.
+ */
+PGECollisionWorld* pge_collision_world_create(GRect bounds, int cell_size, uint16_t max_bodies);
+
+/**
+ * Destroy a collision world. Sprites added to it are not destroyed.
+ */
+void pge_collision_world_destroy(PGECollisionWorld *this);
+
+/**
+ * Add a sprite in a group. The context is passed back when it collides.
+ * Returns a body ID for removing it later, or -1 if the world is full.
+ *
+ * Note: The sprite is not tested until the next pge_collision_world_update()
+ */
+int pge_collision_world_add(PGECollisionWorld *this, PGESprite *sprite, uint8_t group, void *context);
+
+/**
+ * Remove a body. Safe to call from a PGECollisionPairHandler, after which the
+ * body is not reported again.
+ */
+void pge_collision_world_remove(PGECollisionWorld *this, int body_id);
+
+/**
+ * Cache the bounds of all sprites and re-bucket them.
+ * Call once per frame after moving sprites, before finding pairs.
+ */
+void pge_collision_world_update(PGECollisionWorld *this);
+
+/**
+ * Find all overlapping pairs of bodies with one in group_a and the other in
+ * group_b, calling the handler once for each pair.
+ */
+void pge_collision_world_find_pairs(PGECollisionWorld *this, uint8_t group_a, uint8_t group_b, PGECollisionPairHandler *handler);
@@ -7,6 +7,11 @@
  */
 void pge_grid_set_tile_size(int new_tile_size);
 
+/**
+ * Get the side size of the grid tiles
+ */
+int pge_grid_get_tile_size();
+
 /**
  * Get the grid dimensions of the screen with the current tile size
  */
@@ -0,0 +1,66 @@
+/**
+ * Optional fixed-capacity object pool add-on for PGE
+ *
+ * 1. Create a pool once for each type of game entity, sized for the most that
+ *    can exist at once;
+ * 2. Acquire and release entities during the game without using the heap;
+ * 3. Iterate only over the entities that are currently live.
+ */
+
+#pragma once
+
+#include <pebble.h>
+
+// Preallocated slab of equally sized items
+typedef struct {
+  uint8_t *slab;
+  size_t item_size;
+  uint16_t capacity;
+  uint16_t count;
+  uint16_t *slots;      // Live slot indices first, then free ones
+  uint16_t *positions;  // Position of each slot in slots
+} PGEPool;
+
+/**
+ * Create a pool of capacity items of item_size bytes.
+ * All memory is allocated here and nowhere else.
+ */
+PGEPool* pge_pool_create(size_t item_size, uint16_t capacity);
+
+/**
+ * Destroy a pool and all items in it
+ */
+void pge_pool_destroy(PGEPool *this);
+
+/**
+ * Take a zeroed item from the pool. Returns NULL if the pool is full.
+ */
+void* pge_pool_acquire(PGEPool *this);
+
+/**
+ * Return an item to the pool.
+ *
+ * Note: The last live item takes its place in iteration order, so iterate
+ * backwards when releasing items during iteration.
+ */
+void pge_pool_release(PGEPool *this, void *item);
+
+/**
+ * Release all items at once
+ */
+void pge_pool_clear(PGEPool *this);
+
+/**
+ * Get the number of live items
+ */
+int pge_pool_get_count(PGEPool *this);
+
+/**
+ * Get the maximum number of items
+ */
+int pge_pool_get_capacity(PGEPool *this);
+
+/**
+ * Get a live item by index, from 0 to pge_pool_get_count() - 1
+ */
+void* pge_pool_get(PGEPool *this, int index);
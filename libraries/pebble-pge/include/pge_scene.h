@@ -0,0 +1,73 @@
+/**
+ * Optional layered scene add-on for PGE
+ *
+ * 1. Create a scene and add layers bottom to top, marking those that rarely
+ *    change as static;
+ * 2. Call pge_scene_draw() from the PGERenderHandler;
+ * 3. Invalidate a static layer when what it draws changes.
+ *
+ * Static layers below the first dynamic layer are drawn once and cached in an
+ * offscreen GBitmap, which is copied back each frame instead of redrawing them.
+ */
+
+#pragma once
+
+#include <pebble.h>
+
+#include "pge.h"
+
+// Most layers in one scene
+#define PGE_SCENE_MAX_LAYERS 8
+
+// Function to draw one layer of a scene
+typedef void (PGESceneLayerRenderHandler)(GContext *ctx, void *context);
+
+typedef struct {
+  PGESceneLayerRenderHandler *render_handler;
+  void *context;
+  bool is_static;
+  bool is_hidden;
+} PGESceneLayer;
+
+typedef struct {
+  PGESceneLayer layers[PGE_SCENE_MAX_LAYERS];
+  int num_layers;
+  GBitmap *cache;    // Copy of the framebuffer after the cached layers are drawn
+  int num_cached;    // Number of bottom layers the cache holds
+  bool cache_valid;
+  bool cache_failed;  // Not enough memory, so every layer is drawn each frame
+} PGEScene;
+
+/**
+ * Create an empty scene
+ */
+PGEScene* pge_scene_create();
+
+/**
+ * Destroy a scene and its cache
+ */
+void pge_scene_destroy(PGEScene *this);
+
+/**
+ * Add a layer on top of those already added. Returns its index, or -1 if the
+ * scene is full.
+ *
+ * Note: Only static layers below every visible dynamic layer can be cached,
+ * any static layers above one are drawn every frame.
+ */
+int pge_scene_add_layer(PGEScene *this, PGESceneLayerRenderHandler *render_handler, void *context, bool is_static);
+
+/**
+ * Show or hide a layer
+ */
+void pge_scene_set_layer_hidden(PGEScene *this, int layer, bool hidden);
+
+/**
+ * Redraw a static layer next frame, such as when what it shows has changed
+ */
+void pge_scene_invalidate_layer(PGEScene *this, int layer);
+
+/**
+ * Draw the scene, to be called from the PGERenderHandler
+ */
+void pge_scene_draw(PGEScene *this, GContext *ctx);
@@ -9,27 +9,101 @@
  
 #include <pebble.h>
 
+// Frame carved out of an atlas sheet, shared by all sprites showing it
+typedef struct {
+  GBitmap *bitmap;
+  uint16_t ref_count;
+} PGESpriteAtlasFrame;
+
+// Sheet of equally sized animation frames loaded from a single resource
+typedef struct {
+  GBitmap *sheet;
+  GSize frame_size;
+  int num_frames;
+  int columns;
+  PGESpriteAtlasFrame *frames;
+  uint16_t ref_count;
+} PGESpriteAtlas;
+
 // Sprite base object
 typedef struct {
   GBitmap *bitmap;
   GPoint position;
+  GSize size;             // Cached size of bitmap
+  PGESpriteAtlas *atlas;  // NULL if the bitmap is owned by the sprite
+  int atlas_frame;
 } PGESprite;
 
+/**
+ * Create a sprite atlas from a sheet resource made of frames of frame_size,
+ * numbered left to right then top to bottom.
+ * The sheet is loaded once and frames are shared between sprites.
+ *
+ * Returns NULL if the sheet can't be loaded or frame_size doesn't fit it.
+ *
+ * Note: Use GSize(0, 0) to use the whole image as a single frame
+ */
+PGESpriteAtlas* pge_sprite_atlas_create(int sheet_resource_id, GSize frame_size);
+
+/**
+ * Destroy a sprite atlas. Memory is freed once no sprites use it any more.
+ */
+void pge_sprite_atlas_destroy(PGESpriteAtlas *this);
+
+/**
+ * Get the number of frames in the atlas
+ */
+int pge_sprite_atlas_get_num_frames(PGESpriteAtlas *this);
+
+/**
+ * Free cached frames no sprites are currently showing
+ */
+void pge_sprite_atlas_trim(PGESpriteAtlas *this);
+
 /**
  * Create a sprite object
  */
 PGESprite* pge_sprite_create(GPoint position, int initial_resource_id);
 
+/**
+ * Create a sprite object showing a frame from an atlas
+ */
+PGESprite* pge_sprite_create_with_atlas(GPoint position, PGESpriteAtlas *atlas, int initial_frame);
+
 /**
  * Destroy a sprite object
  */
 void pge_sprite_destroy(PGESprite *this);
 
+/**
+ * Initialise a sprite embedded in another object, such as one from a PGEPool
+ */
+void pge_sprite_init(PGESprite *this, GPoint position, int initial_resource_id);
+
+/**
+ * Initialise an embedded sprite showing a frame from an atlas.
+ * Does not allocate once the frame is cached. Returns false if the frame is invalid
+ * or there is not enough memory for it.
+ */
+bool pge_sprite_init_with_atlas(PGESprite *this, GPoint position, PGESpriteAtlas *atlas, int initial_frame);
+
+/**
+ * Release the resources of an embedded sprite, without freeing it
+ */
+void pge_sprite_deinit(PGESprite *this);
+
 /**
  * Set the current animation frame
  */
 void pge_sprite_set_anim_frame(PGESprite *this, int resource_id);
 
+/**
+ * Set the current animation frame from the sprite's atlas.
+ * Does not load any resources, so is cheap to call every frame.
+ * Keeps the current frame if there is not enough memory for the new one.
+ */
+void pge_sprite_set_atlas_frame(PGESprite *this, int frame);
+
 /**
  * Draw the sprite's bitmap to the graphics context
  */
@@ -55,6 +129,15 @@ void pge_sprite_move(PGESprite *this, int dx, int dy);
  */
 bool pge_check_collision(PGESprite* sprite1, PGESprite *sprite2);
 
+/**
+ * Test to see if two entities at their current positions will collide while
+ * moving by their velocities this frame. On a hit, time_of_impact is set from
+ * 0 to PGE_COLLISION_TIME_MAX for how far through the movement they touch.
+ *
+ * Note: time_of_impact can be NULL if not needed
+ */
+bool pge_check_swept_collision(PGESprite *sprite1, GPoint velocity1, PGESprite *sprite2, GPoint velocity2, int32_t *time_of_impact);
+
 /**
  * Get the on-screen bounds of the PGESprite
  */
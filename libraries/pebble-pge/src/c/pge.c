@@ -13,15 +13,59 @@ static PGERenderHandler *s_render_handler;
 static PGEClickHandler *s_click_handler;
 
 static bool s_button_states[3];
+static uint32_t s_button_press_ms[3];
 static bool s_is_paused;
-static int s_framerate = 1000 / 30;
+static int s_framerate = PGE_DEFAULT_FRAMERATE;
 static int s_frame_counter, s_avg_framerate;
 static time_t s_last_report;
 
+// Scheduler
+static uint32_t s_last_tick_ms, s_lag_ms;
+static bool s_render_pending;
+static uint32_t s_pending_logic_ms;  // Spent in logic ticks since the last render
+static PGEFrameStats s_frame_stats;
+
+// Power
+static PGEPowerPolicy s_power_policy = {
+  .mode = PGEPowerModeAlwaysOn,
+  .idle_framerate = 1,
+  .idle_after_ms = PGE_DEFAULT_IDLE_TIMEOUT_MS
+};
+static uint32_t s_last_activity_ms;
+static bool s_activity, s_is_idle;
+
+// Profiler
+static bool s_profiler_enabled;
+static PGEProfilerOutput s_profiler_output;
+static uint16_t s_profiler_samples[PGEProfilerPhaseCount][PGE_PROFILER_SAMPLES];
+static int s_profiler_head, s_profiler_count;
+static char s_profiler_text[32];
+
+// Dirty rectangles
+static bool s_dirty_rects_enabled;
+static GColor s_bg_color;
+static GRect s_dirty_rects[PGE_MAX_DIRTY_RECTS], s_frame_rects[PGE_MAX_DIRTY_RECTS];
+static int s_num_dirty_rects, s_num_frame_rects;
+
+// Input
+static PGEInputEvent s_input_queue[PGE_INPUT_QUEUE_SIZE];
+static int s_input_head, s_input_count;
+
 // Internal prototypes
 static void game_window_load(Window *window);
 static void game_window_unload(Window *window);
+static void game_window_appear(Window *window);
 static void frame_timer_handler(void *context);
+static void start_frame_timer();
+static uint32_t get_time_ms();
+static uint32_t get_tick_period();
+static void update_idle(uint32_t now);
+static int get_button_index(ButtonId button);
+static void profiler_record(int logic_ms, int render_ms, int fb_ms);
+static void profiler_draw_hud(GContext *ctx);
+static bool rects_touch(GRect a, GRect b);
+static bool rects_overlap(GRect a, GRect b);
+static GRect rect_union(GRect a, GRect b);
 static void draw_frame_update_proc(Layer *layer, GContext *ctx);
 static void click_config_provider(void *context);
 
@@ -44,16 +88,17 @@ void pge_begin(PGELogicHandler *logic_handler, PGERenderHandler *render_handler,
 #if defined(PBL_SDK_2)
   window_set_fullscreen(s_game_window, true);
 #endif
-  window_set_background_color(s_game_window, GColorBlack);
+  s_bg_color = GColorBlack;
+  window_set_background_color(s_game_window, s_dirty_rects_enabled ? GColorClear : s_bg_color);
   window_set_window_handlers(s_game_window, (WindowHandlers) {
     .load = game_window_load,
+    .appear = game_window_appear,
     .unload = game_window_unload
   });
 
-  if(click_handler != NULL) {
-    s_click_handler = click_handler;
-    window_set_click_config_provider(s_game_window, click_config_provider);
-  }
+  // Button states and events are tracked even without a click handler
+  s_click_handler = click_handler;
+  window_set_click_config_provider(s_game_window, click_config_provider);
 
   // Go!
   window_stack_push(s_game_window, true);
@@ -69,22 +114,48 @@ void pge_finish() {
 
   // Finally
   window_destroy(s_game_window);
+  s_game_window = NULL;
 }
 
 bool pge_get_button_state(ButtonId button) {
-  switch(button) {
-    case BUTTON_ID_UP:
-      return s_button_states[0];
-    case BUTTON_ID_SELECT:
-      return s_button_states[1];
-    case BUTTON_ID_DOWN:
-      return s_button_states[2];
-    default:
-      return false;
+  int index = get_button_index(button);
+  return (index >= 0) ? s_button_states[index] : false;
+}
+
+bool pge_input_poll(PGEInputEvent *event) {
+  if(s_input_count == 0) {
+    return false;
+  }
+
+  *event = s_input_queue[s_input_head];
+  s_input_head = (s_input_head + 1) % PGE_INPUT_QUEUE_SIZE;
+  s_input_count--;
+  return true;
+}
+
+void pge_input_clear() {
+  s_input_head = 0;
+  s_input_count = 0;
+}
+
+int pge_get_button_held_ms(ButtonId button) {
+  int index = get_button_index(button);
+  if(index < 0 || !s_button_states[index]) {
+    return 0;
   }
+  return get_time_ms() - s_button_press_ms[index];
+}
+
+uint32_t pge_get_time_ms() {
+  return get_time_ms();
 }
 
 void pge_set_framerate(int new_rate) {
+  if(new_rate < 1) {
+    new_rate = 1;
+  } else if(new_rate > PGE_MAX_FRAMERATE) {
+    new_rate = PGE_MAX_FRAMERATE;
+  }
   s_framerate = new_rate;
 }
 
@@ -94,13 +165,27 @@ void pge_set_background(int bg_resource_id) {
   }
   s_bg_bitmap = gbitmap_create_with_resource(bg_resource_id);
   bitmap_layer_set_bitmap(s_bg_layer, s_bg_bitmap);
+  pge_mark_all_dirty();
 }
 
 void pge_set_background_color(GColor color) {
-  window_set_background_color(s_game_window, color);
+  s_bg_color = color;
+  if(s_dirty_rects_enabled) {
+    // Background is restored by the engine instead
+    pge_mark_all_dirty();
+  } else {
+    window_set_background_color(s_game_window, color);
+  }
 }
 
 void pge_manual_advance() {
+  if(s_logic_handler != NULL) {
+    uint32_t start = get_time_ms();
+    s_logic_handler();
+    s_pending_logic_ms += get_time_ms() - start;
+  }
+  s_render_pending = true;
+  pge_mark_all_dirty();
   layer_mark_dirty(s_canvas);
 }
 
@@ -112,6 +197,96 @@ int pge_get_average_framerate() {
   return s_avg_framerate;
 }
 
+void pge_set_dirty_rects_enabled(bool enabled) {
+  s_dirty_rects_enabled = enabled;
+  s_num_dirty_rects = 0;
+
+  // Stop the Window and background Layer clearing the whole screen
+  if(s_game_window) {
+    window_set_background_color(s_game_window, enabled ? GColorClear : s_bg_color);
+  }
+  if(s_bg_layer) {
+    layer_set_hidden(bitmap_layer_get_layer(s_bg_layer), enabled);
+  }
+  pge_mark_all_dirty();
+}
+
+bool pge_get_dirty_rects_enabled() {
+  return s_dirty_rects_enabled;
+}
+
+void pge_mark_dirty_rect(GRect rect) {
+  // Something on screen changed
+  s_activity = true;
+
+  if(!s_dirty_rects_enabled || !s_canvas) {
+    return;
+  }
+
+  GRect screen = layer_get_bounds(s_canvas);
+  grect_clip(&rect, &screen);
+  if(grect_is_empty(&rect)) {
+    return;
+  }
+
+  // Absorb any regions this one touches, which may then touch others
+  int i = 0;
+  while(i < s_num_dirty_rects) {
+    if(rects_touch(rect, s_dirty_rects[i])) {
+      rect = rect_union(rect, s_dirty_rects[i]);
+      s_num_dirty_rects--;
+      s_dirty_rects[i] = s_dirty_rects[s_num_dirty_rects];
+      i = 0;
+    } else {
+      i++;
+    }
+  }
+
+  if(s_num_dirty_rects == PGE_MAX_DIRTY_RECTS) {
+    // Out of slots, collapse to a single region
+    for(i = 0; i < s_num_dirty_rects; i++) {
+      rect = rect_union(rect, s_dirty_rects[i]);
+    }
+    s_num_dirty_rects = 0;
+  }
+  s_dirty_rects[s_num_dirty_rects++] = rect;
+}
+
+void pge_mark_all_dirty() {
+  if(s_canvas) {
+    pge_mark_dirty_rect(layer_get_bounds(s_canvas));
+  }
+}
+
+int pge_get_dirty_rects(const GRect **rects) {
+  *rects = s_frame_rects;
+  return s_num_frame_rects;
+}
+
+bool pge_is_rect_dirty(GRect rect) {
+  if(!s_dirty_rects_enabled) {
+    return true;
+  }
+
+  for(int i = 0; i < s_num_frame_rects; i++) {
+    if(rects_overlap(rect, s_frame_rects[i])) {
+      return true;
+    }
+  }
+  return false;
+}
+
+PGEFrameStats pge_get_frame_stats() {
+  s_frame_stats.budget_ms = 1000 / s_framerate;
+  return s_frame_stats;
+}
+
+void pge_reset_frame_stats() {
+  s_frame_stats = (PGEFrameStats){
+    .budget_ms = 1000 / s_framerate
+  };
+}
+
 void pge_pause() {
   if(!s_is_paused){
     s_is_paused = true;
@@ -126,7 +301,9 @@ void pge_pause() {
 void pge_resume() {
   if(s_is_paused) {
     s_is_paused = false;
-    s_render_timer = app_timer_register(1000 / s_framerate, frame_timer_handler, NULL);
+    s_is_idle = false;
+    s_last_activity_ms = get_time_ms();
+    start_frame_timer();
   }
 }
 
@@ -134,25 +311,359 @@ bool pge_is_paused() {
   return s_is_paused;
 }
 
+void pge_profiler_set_enabled(bool enabled, PGEProfilerOutput output) {
+  s_profiler_enabled = enabled;
+  s_profiler_output = output;
+  pge_profiler_reset();
+}
+
+bool pge_profiler_get_enabled() {
+  return s_profiler_enabled;
+}
+
+int pge_profiler_get_num_samples() {
+  return s_profiler_count;
+}
+
+PGEProfilerSummary pge_profiler_get_summary(PGEProfilerPhase phase) {
+  PGEProfilerSummary summary = (PGEProfilerSummary){0};
+  if(phase < 0 || phase >= PGEProfilerPhaseCount || s_profiler_count == 0) {
+    return summary;
+  }
+
+  // Sort a copy, small enough for insertion sort
+  uint16_t sorted[PGE_PROFILER_SAMPLES];
+  int total = 0;
+  for(int i = 0; i < s_profiler_count; i++) {
+    uint16_t value = s_profiler_samples[phase][i];
+    total += value;
+
+    int j = i;
+    while(j > 0 && sorted[j - 1] > value) {
+      sorted[j] = sorted[j - 1];
+      j--;
+    }
+    sorted[j] = value;
+  }
+
+  // Nearest-rank percentile
+  int p95_index = (s_profiler_count * 95 + 99) / 100 - 1;
+  summary.min_ms = sorted[0];
+  summary.avg_ms = total / s_profiler_count;
+  summary.p95_ms = sorted[p95_index];
+  summary.max_ms = sorted[s_profiler_count - 1];
+  return summary;
+}
+
+void pge_profiler_reset() {
+  s_profiler_head = 0;
+  s_profiler_count = 0;
+}
+
+void pge_set_power_policy(PGEPowerPolicy policy) {
+  if(policy.idle_framerate < 1) {
+    policy.idle_framerate = 1;
+  } else if(policy.idle_framerate > PGE_MAX_FRAMERATE) {
+    policy.idle_framerate = PGE_MAX_FRAMERATE;
+  }
+  if(policy.idle_after_ms < 0) {
+    policy.idle_after_ms = 0;
+  }
+  s_power_policy = policy;
+
+  // Start counting again under the new policy
+  pge_wake();
+}
+
+PGEPowerPolicy pge_get_power_policy() {
+  return s_power_policy;
+}
+
+void pge_report_activity() {
+  s_activity = true;
+}
+
+void pge_wake() {
+  s_activity = true;
+  s_last_activity_ms = get_time_ms();
+  if(!s_is_idle) {
+    return;
+  }
+  s_is_idle = false;
+
+  // Replace the idle schedule with one at the full framerate
+  if(s_render_timer) {
+    app_timer_cancel(s_render_timer);
+    s_render_timer = NULL;
+  }
+  if(!s_is_paused && s_canvas) {
+    start_frame_timer();
+  }
+}
+
+bool pge_is_idle() {
+  return s_is_idle;
+}
+
 /************************* Engine Internal Functions **************************/
 
+static uint32_t get_time_ms() {
+  time_t seconds;
+  uint16_t millis;
+  time_ms(&seconds, &millis);
+
+  // Wraps, but only differences are ever used
+  return ((uint32_t)seconds * 1000) + millis;
+}
+
+static int get_button_index(ButtonId button) {
+  switch(button) {
+    case BUTTON_ID_UP:
+      return 0;
+    case BUTTON_ID_SELECT:
+      return 1;
+    case BUTTON_ID_DOWN:
+      return 2;
+    default:
+      return -1;
+  }
+}
+
+static void queue_input_event(ButtonId button, PGEInputEventType type, uint32_t now) {
+  if(s_input_count == PGE_INPUT_QUEUE_SIZE) {
+    // Full, drop the oldest so the latest input is kept
+    s_input_head = (s_input_head + 1) % PGE_INPUT_QUEUE_SIZE;
+    s_input_count--;
+  }
+
+  s_input_queue[(s_input_head + s_input_count) % PGE_INPUT_QUEUE_SIZE] = (PGEInputEvent) {
+    .button = button,
+    .type = type,
+    .time_ms = now
+  };
+  s_input_count++;
+}
+
+static void button_pressed(ButtonId button) {
+  int index = get_button_index(button);
+  uint32_t now = get_time_ms();
+  s_button_states[index] = true;
+  s_button_press_ms[index] = now;
+  queue_input_event(button, PGEInputEventTypePress, now);
+  pge_wake();
+}
+
+static void button_released(ButtonId button) {
+  s_button_states[get_button_index(button)] = false;
+  queue_input_event(button, PGEInputEventTypeRelease, get_time_ms());
+}
+
+static uint32_t get_tick_period() {
+  if(s_is_idle && s_power_policy.mode == PGEPowerModeLowRate) {
+    return 1000 / s_power_policy.idle_framerate;
+  }
+  return 1000 / s_framerate;
+}
+
+static void update_idle(uint32_t now) {
+  // Held buttons keep the game awake even if nothing moves
+  bool held = s_button_states[0] || s_button_states[1] || s_button_states[2];
+  if(s_activity || held) {
+    s_activity = false;
+    s_last_activity_ms = now;
+    s_is_idle = false;
+    return;
+  }
+
+  if(!s_is_idle && s_power_policy.mode != PGEPowerModeAlwaysOn
+      && now - s_last_activity_ms >= (uint32_t)s_power_policy.idle_after_ms) {
+    s_is_idle = true;
+  }
+}
+
+static bool rects_touch(GRect a, GRect b) {
+  return a.origin.x <= b.origin.x + b.size.w && b.origin.x <= a.origin.x + a.size.w
+    && a.origin.y <= b.origin.y + b.size.h && b.origin.y <= a.origin.y + a.size.h;
+}
+
+static bool rects_overlap(GRect a, GRect b) {
+  return a.origin.x < b.origin.x + b.size.w && b.origin.x < a.origin.x + a.size.w
+    && a.origin.y < b.origin.y + b.size.h && b.origin.y < a.origin.y + a.size.h;
+}
+
+static GRect rect_union(GRect a, GRect b) {
+  int x0 = MIN(a.origin.x, b.origin.x);
+  int y0 = MIN(a.origin.y, b.origin.y);
+  int x1 = MAX(a.origin.x + a.size.w, b.origin.x + b.size.w);
+  int y1 = MAX(a.origin.y + a.size.h, b.origin.y + b.size.h);
+  return GRect(x0, y0, x1 - x0, y1 - y0);
+}
+
+#if defined(PBL_BW)
+static void write_span(uint8_t *row, const uint8_t *src, uint8_t fill, int x0, int x1) {
+  // Pixels x0 to x1 inclusive, one bit each, with partial bytes at either end
+  int b0 = x0 / 8;
+  int b1 = x1 / 8;
+  uint8_t first = 0xFF << (x0 % 8);
+  uint8_t last = 0xFF >> (7 - (x1 % 8));
+  if(b0 == b1) {
+    first &= last;
+  }
+
+  row[b0] = (row[b0] & ~first) | ((src ? src[b0] : fill) & first);
+  if(b1 > b0) {
+    if(b1 - b0 > 1) {
+      if(src) {
+        memcpy(&row[b0 + 1], &src[b0 + 1], b1 - b0 - 1);
+      } else {
+        memset(&row[b0 + 1], fill, b1 - b0 - 1);
+      }
+    }
+    row[b1] = (row[b1] & ~last) | ((src ? src[b1] : fill) & last);
+  }
+}
+#elif defined(PBL_COLOR)
+static void write_span(uint8_t *row, const uint8_t *src, uint8_t fill, int x0, int x1) {
+  if(src) {
+    memcpy(&row[x0], &src[x0], x1 - x0 + 1);
+  } else {
+    memset(&row[x0], fill, x1 - x0 + 1);
+  }
+}
+#endif
+
+/**
+ * Returns how long the framebuffer was held, from capture to release
+ */
+static uint32_t restore_background(GContext *ctx) {
+  uint32_t start = get_time_ms();
+  GBitmap *fb = graphics_capture_frame_buffer(ctx);
+  if(!fb) {
+    return get_time_ms() - start;
+  }
+
+  // Copy rows of the background straight in if it matches the screen
+  bool copy_bg = s_bg_bitmap && gbitmap_get_format(s_bg_bitmap) == gbitmap_get_format(fb);
+  GSize bg_size = copy_bg ? gbitmap_get_bounds(s_bg_bitmap).size : GSize(0, 0);
+#if defined(PBL_BW)
+  uint8_t fill = gcolor_equal(s_bg_color, GColorWhite) ? 0xFF : 0x00;
+#elif defined(PBL_COLOR)
+  uint8_t fill = s_bg_color.argb;
+#endif
+
+  for(int i = 0; i < s_num_frame_rects; i++) {
+    GRect rect = s_frame_rects[i];
+    for(int y = rect.origin.y; y < rect.origin.y + rect.size.h; y++) {
+      GBitmapDataRowInfo info = gbitmap_get_data_row_info(fb, y);
+      int x0 = MAX(rect.origin.x, info.min_x);
+      int x1 = MIN(rect.origin.x + rect.size.w - 1, info.max_x);
+      if(x0 > x1) {
+        continue;
+      }
+
+      const uint8_t *src = NULL;
+      if(copy_bg && y < bg_size.h && x1 < bg_size.w) {
+        src = gbitmap_get_data_row_info(s_bg_bitmap, y).data;
+      }
+      write_span(info.data, src, fill, x0, x1);
+    }
+  }
+  graphics_release_frame_buffer(ctx, fb);
+  uint32_t fb_ms = get_time_ms() - start;
+
+  if(s_bg_bitmap && !copy_bg) {
+    // Different format, let the system convert the affected regions
+    GRect bg_bounds = gbitmap_get_bounds(s_bg_bitmap);
+    for(int i = 0; i < s_num_frame_rects; i++) {
+      GRect rect = s_frame_rects[i];
+      GRect bg_rect = GRect(0, 0, bg_bounds.size.w, bg_bounds.size.h);
+      grect_clip(&rect, &bg_rect);
+      if(grect_is_empty(&rect)) {
+        continue;
+      }
+
+      gbitmap_set_bounds(s_bg_bitmap, GRect(
+        bg_bounds.origin.x + rect.origin.x, bg_bounds.origin.y + rect.origin.y, rect.size.w, rect.size.h));
+      graphics_draw_bitmap_in_rect(ctx, s_bg_bitmap, rect);
+    }
+    gbitmap_set_bounds(s_bg_bitmap, bg_bounds);
+  }
+  return fb_ms;
+}
+
+static void start_frame_timer() {
+  // Start a fresh schedule so time spent paused or loading isn't caught up
+  s_last_tick_ms = get_time_ms();
+  s_lag_ms = 0;
+  s_last_report = time(NULL);
+  s_frame_counter = 0;
+  s_render_timer = app_timer_register(get_tick_period(), frame_timer_handler, NULL);
+}
+
 static void count_framerate() {
+  s_frame_counter++;
+
   time_t now = time(NULL);
-  if(now - s_last_report > PGE_FRAMERATE_INTERVAL_S) {
+  time_t elapsed = now - s_last_report;
+  if(elapsed >= PGE_FRAMERATE_INTERVAL_S) {
+    // Frames since the last report, over however long it actually was
+    s_avg_framerate = s_frame_counter / elapsed;
     s_last_report = now;
-    s_avg_framerate = s_frame_counter / PGE_FRAMERATE_INTERVAL_S;
     s_frame_counter = 0;
-  } else {
-    s_frame_counter++;
   }
 }
 
+static void profiler_record(int logic_ms, int render_ms, int fb_ms) {
+  int head = s_profiler_head;
+  s_profiler_samples[PGEProfilerPhaseLogic][head] = logic_ms;
+  s_profiler_samples[PGEProfilerPhaseRender][head] = render_ms;
+  s_profiler_samples[PGEProfilerPhaseFramebuffer][head] = fb_ms;
+  s_profiler_samples[PGEProfilerPhaseFrame][head] = logic_ms + render_ms + fb_ms;
+
+  s_profiler_head = (head + 1) % PGE_PROFILER_SAMPLES;
+  if(s_profiler_count < PGE_PROFILER_SAMPLES) {
+    s_profiler_count++;
+  }
+
+  if((s_profiler_output & PGEProfilerOutputLog) && s_profiler_head == 0) {
+    // Once per full buffer, so the log isn't flooded
+    static const char *s_names[PGEProfilerPhaseCount] = { "logic", "render", "fb", "frame" };
+    for(int i = 0; i < PGEProfilerPhaseCount; i++) {
+      PGEProfilerSummary summary = pge_profiler_get_summary(i);
+      APP_LOG(APP_LOG_LEVEL_INFO, "PGE %s ms: min %d avg %d p95 %d max %d",
+        s_names[i], summary.min_ms, summary.avg_ms, summary.p95_ms, summary.max_ms);
+    }
+  }
+}
+
+static void profiler_draw_hud(GContext *ctx) {
+  PGEProfilerSummary logic = pge_profiler_get_summary(PGEProfilerPhaseLogic);
+  PGEProfilerSummary render = pge_profiler_get_summary(PGEProfilerPhaseRender);
+  PGEProfilerSummary fb = pge_profiler_get_summary(PGEProfilerPhaseFramebuffer);
+  PGEProfilerSummary frame = pge_profiler_get_summary(PGEProfilerPhaseFrame);
+  snprintf(s_profiler_text, sizeof(s_profiler_text), "%d/%d/%d\n%d p95 %d",
+    logic.avg_ms, render.avg_ms, fb.avg_ms, frame.avg_ms, frame.p95_ms);
+
+  GRect hud_rect = GRect(0, 0, 64, 32);
+  graphics_context_set_fill_color(ctx, GColorBlack);
+  graphics_fill_rect(ctx, hud_rect, 0, GCornerNone);
+  graphics_context_set_text_color(ctx, GColorWhite);
+  graphics_draw_text(ctx, s_profiler_text, fonts_get_system_font(FONT_KEY_GOTHIC_14),
+    hud_rect, GTextOverflowModeTrailingEllipsis, GTextAlignmentLeft, NULL);
+
+  // Redraw it next frame too, without keeping an otherwise idle game awake
+  bool activity = s_activity;
+  pge_mark_dirty_rect(hud_rect);
+  s_activity = activity;
+}
+
 static void game_window_load(Window *window) {
   Layer *window_layer = window_get_root_layer(window);
   GRect window_bounds = layer_get_bounds(window_layer);
 
   // Set up background
   s_bg_layer = bitmap_layer_create(GRect(0, 0, window_bounds.size.w, window_bounds.size.h));
+  layer_set_hidden(bitmap_layer_get_layer(s_bg_layer), s_dirty_rects_enabled);
   layer_add_child(window_layer, bitmap_layer_get_layer(s_bg_layer));
 
   // Set up canvas
@@ -161,62 +672,150 @@ static void game_window_load(Window *window) {
   layer_add_child(window_layer, s_canvas);
 
   // Register new Timer to begin frame rendering loop
-  s_render_timer = app_timer_register(1000 / s_framerate, frame_timer_handler, NULL);
+  s_last_activity_ms = get_time_ms();
+  start_frame_timer();
 }
 
 static void game_window_unload(Window *window) {
   // Destroy canvas
   layer_destroy(s_canvas);
+  s_canvas = NULL;
   bitmap_layer_destroy(s_bg_layer);
+  s_bg_layer = NULL;
   gbitmap_destroy(s_bg_bitmap);
   s_bg_bitmap = NULL;
 }
 
+static void game_window_appear(Window *window) {
+  // Anything may have been drawn over the framebuffer while hidden
+  pge_mark_all_dirty();
+}
+
 static void frame_timer_handler(void *context) {
-  if(s_logic_handler != NULL && s_render_handler != NULL) {
-    // Do this frame
+  s_render_timer = NULL;
+  if(s_logic_handler == NULL || s_render_handler == NULL) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Loop or Render handler not set!");
+    return;
+  }
+
+  const uint32_t period = get_tick_period();
+  const uint32_t now = get_time_ms();
+  s_lag_ms += now - s_last_tick_ms;
+  s_last_tick_ms = now;
+
+  // After a long stall, drop the backlog rather than spiral
+  if(s_lag_ms > period * PGE_MAX_FRAME_SKIP) {
+    s_lag_ms = period * PGE_MAX_FRAME_SKIP;
+  }
+
+  // Run as many fixed logic ticks as are due
+  int ticks = 0;
+  while(s_lag_ms >= period) {
+    s_logic_handler();
+    s_lag_ms -= period;
+    ticks++;
+  }
+
+  if(ticks > 0) {
+    s_pending_logic_ms += get_time_ms() - now;
+
+    // Only the latest state is rendered, the rest are skipped
+    int skipped = ticks - 1;
+    if(s_render_pending) {
+      // Previous render never happened before this tick
+      skipped++;
+    }
+    s_frame_stats.skipped_frames += skipped;
+
+    s_render_pending = true;
     layer_mark_dirty(s_canvas);
+  }
 
-    // Next frame
-    s_render_timer = app_timer_register(1000 / s_framerate, frame_timer_handler, NULL);
-  } else {
-    APP_LOG(APP_LOG_LEVEL_ERROR, "Loop or Render handler not set!");
+  update_idle(now);
+  if(s_is_idle && s_power_policy.mode == PGEPowerModePause) {
+    // The last state is already drawn, wait for pge_wake()
+    return;
+  }
+  if(period != get_tick_period()) {
+    // Went idle or woke up, restart the schedule at the new rate
+    start_frame_timer();
+    return;
   }
+
+  // Aim at the next tick boundary, not a fixed delay after this one
+  uint32_t spent = get_time_ms() - now;
+  uint32_t until_next = period - s_lag_ms;
+  uint32_t delay = (spent < until_next) ? until_next - spent : 1;
+  s_render_timer = app_timer_register(delay, frame_timer_handler, NULL);
 }
 
 static void draw_frame_update_proc(Layer *layer, GContext *ctx) {
-  // Render and logic
   if(s_logic_handler != NULL && s_render_handler != NULL) {
-    s_render_handler(ctx);
-    s_logic_handler();
+    uint32_t start = get_time_ms();
+    uint32_t fb_ms = 0;
+    if(s_dirty_rects_enabled) {
+      // Take this frame's regions, any marked while rendering go to the next
+      memcpy(s_frame_rects, s_dirty_rects, s_num_dirty_rects * sizeof(GRect));
+      s_num_frame_rects = s_num_dirty_rects;
+      s_num_dirty_rects = 0;
+
+      // Leave the previous frame untouched outside them
+      if(s_num_frame_rects > 0) {
+        fb_ms = restore_background(ctx);
+        s_render_handler(ctx);
+      }
+      s_num_frame_rects = 0;
+    } else {
+      s_render_handler(ctx);
+    }
+    s_render_pending = false;
     count_framerate();
+
+    // Update budget statistics, with no logic if no tick led to this render
+    s_frame_stats.budget_ms = 1000 / s_framerate;
+    s_frame_stats.last_logic_ms = s_pending_logic_ms;
+    s_pending_logic_ms = 0;
+    s_frame_stats.last_render_ms = get_time_ms() - start;
+    if(s_profiler_enabled) {
+      profiler_record(s_frame_stats.last_logic_ms, s_frame_stats.last_render_ms - fb_ms, fb_ms);
+      if(s_profiler_output & PGEProfilerOutputHUD) {
+        profiler_draw_hud(ctx);
+      }
+    }
+    s_frame_stats.last_frame_ms = s_frame_stats.last_logic_ms + s_frame_stats.last_render_ms;
+    if(s_frame_stats.last_frame_ms > s_frame_stats.max_frame_ms) {
+      s_frame_stats.max_frame_ms = s_frame_stats.last_frame_ms;
+    }
+    if(s_frame_stats.last_frame_ms > s_frame_stats.budget_ms) {
+      s_frame_stats.overruns++;
+    }
   } else {
     APP_LOG(APP_LOG_LEVEL_ERROR, "Loop or Render handler not set!");
   }
 }
 
 static void up_pressed_click_handler(ClickRecognizerRef recognizer, void *context) {
-  s_button_states[0] = true;
+  button_pressed(BUTTON_ID_UP);
 }
 
 static void up_released_click_handler(ClickRecognizerRef recognizer, void *context) {
-  s_button_states[0] = false;
+  button_released(BUTTON_ID_UP);
 }
 
 static void select_pressed_click_handler(ClickRecognizerRef recognizer, void *context) {
-  s_button_states[1] = true;
+  button_pressed(BUTTON_ID_SELECT);
 }
 
 static void select_released_click_handler(ClickRecognizerRef recognizer, void *context) {
-  s_button_states[1] = false;
+  button_released(BUTTON_ID_SELECT);
 }
 
 static void down_pressed_click_handler(ClickRecognizerRef recognizer, void *context) {
-  s_button_states[2] = true;
+  button_pressed(BUTTON_ID_DOWN);
 }
 
 static void down_released_click_handler(ClickRecognizerRef recognizer, void *context) {
-  s_button_states[2] = false;
+  button_released(BUTTON_ID_DOWN);
 }
 
 static void select_click_handler(ClickRecognizerRef recognizer, void *context) {
@@ -248,6 +847,10 @@ static void click_config_provider(void *context) {
   window_raw_click_subscribe(BUTTON_ID_SELECT, select_pressed_click_handler, select_released_click_handler, NULL);
   window_raw_click_subscribe(BUTTON_ID_DOWN, down_pressed_click_handler, down_released_click_handler, NULL);
 
+  if(s_click_handler == NULL) {
+    return;
+  }
+
   window_single_click_subscribe(BUTTON_ID_SELECT, select_click_handler);
   window_single_click_subscribe(BUTTON_ID_UP, up_click_handler);
   window_single_click_subscribe(BUTTON_ID_DOWN, down_click_handler);
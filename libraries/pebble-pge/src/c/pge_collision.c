@@ -1,46 +1,28 @@
 #include "pge_collision.h"
+#include "pge_grid.h"
 
-#define min(a, b) ((a) < (b)) ? (a) : (b)
-#define max(a, b) ((a) > (b)) ? (a) : (b)
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#define max(a, b) (((a) > (b)) ? (a) : (b))
 
 // Uses separated axis theorem where rectangles are aligned with the x and y axis
 bool pge_collision_rectangle_rectangle(GRect *rect_a, GRect *rect_b) {
+  // Extents, allowing for negative sizes
+  int a_x1 = rect_a->origin.x + rect_a->size.w;
+  int a_y1 = rect_a->origin.y + rect_a->size.h;
+  int b_x1 = rect_b->origin.x + rect_b->size.w;
+  int b_y1 = rect_b->origin.y + rect_b->size.h;
+  int a_min_x = min(rect_a->origin.x, a_x1);
+  int a_max_x = max(rect_a->origin.x, a_x1);
+  int a_min_y = min(rect_a->origin.y, a_y1);
+  int a_max_y = max(rect_a->origin.y, a_y1);
+  int b_min_x = min(rect_b->origin.x, b_x1);
+  int b_max_x = max(rect_b->origin.x, b_x1);
+  int b_min_y = min(rect_b->origin.y, b_y1);
+  int b_max_y = max(rect_b->origin.y, b_y1);
 
-  struct overlap_rect{  
-    GPoint ul;  // upper-left
-    GPoint ur;  // upper-right
-    GPoint bl;  // bottom-left
-    GPoint br;  // bottom-right
-  };
-
-  struct overlap_rect overlap_a = (struct overlap_rect){
-    {rect_a->origin.x, rect_a->origin.y},
-    {rect_a->origin.x + rect_a->size.w, rect_a->origin.y},
-    {rect_a->origin.x, rect_a->origin.y + rect_a->size.h},
-    {rect_a->origin.x + rect_a->size.w, rect_a->origin.y + rect_a->size.h}};
-
-  struct overlap_rect overlap_b = (struct overlap_rect){
-    {rect_b->origin.x, rect_b->origin.y},
-    {rect_b->origin.x + rect_b->size.w, rect_b->origin.y},
-    {rect_b->origin.x, rect_b->origin.y + rect_b->size.h},
-    {rect_b->origin.x + rect_b->size.w, rect_b->origin.y + rect_b->size.h}};
-
-   GPoint a_min = GPoint(
-      min( min( overlap_a.ul.x,overlap_a.ur.x),min( overlap_a.bl.x,overlap_a.br.x ) ),
-      min( min( overlap_a.ul.y,overlap_a.ur.y),min( overlap_a.bl.y,overlap_a.br.y ) ) );
-   GPoint a_max = GPoint(
-      max( max( overlap_a.ul.x,overlap_a.ur.x),max( overlap_a.bl.x,overlap_a.br.x ) ),
-      max( max( overlap_a.ul.y,overlap_a.ur.y),max( overlap_a.bl.y,overlap_a.br.y ) ) );
-   GPoint b_min = GPoint(
-      min( min( overlap_b.ul.x,overlap_b.ur.x),min( overlap_b.bl.x,overlap_b.br.x ) ),
-      min( min( overlap_b.ul.y,overlap_b.ur.y),min( overlap_b.bl.y,overlap_b.br.y ) ) );
-   GPoint b_max = GPoint(
-      max( max( overlap_b.ul.x,overlap_b.ur.x),max( overlap_b.bl.x,overlap_b.br.x ) ),
-      max( max( overlap_b.ul.y,overlap_b.ur.y),max( overlap_b.bl.y,overlap_b.br.y ) ) );
-   
-   //checks if cannot overlap, returns true if overlapped
-   return !( a_min.x > b_max.x || a_max.x < b_min.x || 
-      a_min.y > b_max.y || a_max.y < b_min.y );
+  //checks if cannot overlap, returns true if overlapped
+  return !(a_min_x > b_max_x || a_max_x < b_min_x ||
+    a_min_y > b_max_y || a_max_y < b_min_y);
 }
 
 bool pge_collision_line_rectangle(GLine *line, GRect *rect) {
@@ -65,14 +47,20 @@ bool pge_collision_line_rectangle(GLine *line, GRect *rect) {
   return retval;
 }
 
-bool pge_collision_line_line(GLine *line_a, GLine *line_b) {
-  // Dot product, positive results mean point is on one side of a line,
-  // checking both ranges shows if intersection is within segments.
-  return 
-    (((line_b->p1.x-line_a->p1.x)*(line_a->p2.y-line_a->p1.y) + (line_b->p1.y-line_a->p1.y)*(line_a->p2.x-line_a->p1.x)) * ((line_b->p2.x-line_a->p1.x)*(line_a->p2.y-line_a->p1.y) + (line_b->p2.y-line_a->p1.y)*(line_a->p2.x-line_a->p1.x)) < 0) &&
-    (((line_a->p1.x-line_b->p1.x)*(line_b->p2.y-line_b->p1.y) + (line_a->p1.y-line_b->p1.y)*(line_b->p2.x-line_b->p1.x)) * ((line_a->p2.x-line_b->p1.x)*(line_b->p2.y-line_b->p1.y) + (line_a->p2.y-line_b->p1.y)*(line_b->p2.x-line_b->p1.x)) < 0);
+// Which side of line p1 to p2 the point lies, in 64 bits as products of
+// coordinate differences don't fit an int
+static int orientation(GPoint p1, GPoint p2, GPoint point) {
+  int64_t cross = ((int64_t)(p2.x - p1.x) * (point.y - p1.y)) - ((int64_t)(p2.y - p1.y) * (point.x - p1.x));
+  return (cross > 0) - (cross < 0);
 }
 
+bool pge_collision_line_line(GLine *line_a, GLine *line_b) {
+  // Each segment's ends must lie strictly on opposite sides of the other.
+  // Compare signs rather than multiplying, which can overflow.
+  return
+    (orientation(line_a->p1, line_a->p2, line_b->p1) * orientation(line_a->p1, line_a->p2, line_b->p2) < 0) &&
+    (orientation(line_b->p1, line_b->p2, line_a->p1) * orientation(line_b->p1, line_b->p2, line_a->p2) < 0);
+}
 
 bool pge_collision_point_rectangle(GPoint *point, GRect *rect){
   return 
@@ -80,3 +68,286 @@ bool pge_collision_point_rectangle(GPoint *point, GRect *rect){
       (point->y >= rect->origin.y && point->y <= (rect->origin.y + rect->size.h));
 }
 
+/********************************** Swept *************************************/
+
+// Times an interval moving by velocity overlaps a static one, scaled so that
+// PGE_COLLISION_TIME_MAX is the end of the movement
+static bool sweep_axis(int a_min, int a_max, int b_min, int b_max, int velocity, int32_t *entry, int32_t *exit) {
+  if(velocity == 0) {
+    // Must already overlap, and will for the whole movement
+    *entry = INT32_MIN;
+    *exit = INT32_MAX;
+    return a_min <= b_max && a_max >= b_min;
+  }
+
+  int64_t near = (velocity > 0) ? (b_min - a_max) : (b_max - a_min);
+  int64_t far = (velocity > 0) ? (b_max - a_min) : (b_min - a_max);
+  *entry = (near * PGE_COLLISION_TIME_MAX) / velocity;
+  *exit = (far * PGE_COLLISION_TIME_MAX) / velocity;
+  return true;
+}
+
+static bool sweep(GRect *rect_a, GPoint velocity, GRect *rect_b, int32_t *time_of_impact) {
+  int32_t entry_x, exit_x, entry_y, exit_y;
+  if(!sweep_axis(rect_a->origin.x, rect_a->origin.x + rect_a->size.w,
+                 rect_b->origin.x, rect_b->origin.x + rect_b->size.w,
+                 velocity.x, &entry_x, &exit_x)
+  || !sweep_axis(rect_a->origin.y, rect_a->origin.y + rect_a->size.h,
+                 rect_b->origin.y, rect_b->origin.y + rect_b->size.h,
+                 velocity.y, &entry_y, &exit_y)) {
+    return false;
+  }
+
+  // Touching only while overlapping on both axes at once
+  int32_t entry = max(entry_x, entry_y);
+  int32_t exit = min(exit_x, exit_y);
+  if(entry > exit || entry > PGE_COLLISION_TIME_MAX || exit < 0) {
+    return false;
+  }
+
+  if(time_of_impact) {
+    *time_of_impact = max(entry, 0);
+  }
+  return true;
+}
+
+bool pge_collision_swept_rectangle_rectangle(GRect *rect_a, GPoint velocity_a, GRect *rect_b, GPoint velocity_b, int32_t *time_of_impact) {
+  // Move a relative to b
+  GPoint relative = GPoint(velocity_a.x - velocity_b.x, velocity_a.y - velocity_b.y);
+  return sweep(rect_a, relative, rect_b, time_of_impact);
+}
+
+bool pge_collision_line_rectangle_swept(GLine *line, GRect *rect, int32_t *time_of_impact) {
+  // A point moving from one end to the other
+  GRect point = GRect(line->p1.x, line->p1.y, 0, 0);
+  GPoint delta = GPoint(line->p2.x - line->p1.x, line->p2.y - line->p1.y);
+  return sweep(&point, delta, rect, time_of_impact);
+}
+
+/****************************** Collision World *******************************/
+
+static int clamp(int value, int low, int high) {
+  return (value < low) ? low : ((value > high) ? high : value);
+}
+
+static int cell_column(PGECollisionWorld *this, int x) {
+  return clamp((x - this->bounds.origin.x) / this->cell_size, 0, this->columns - 1);
+}
+
+static int cell_row(PGECollisionWorld *this, int y) {
+  return clamp((y - this->bounds.origin.y) / this->cell_size, 0, this->rows - 1);
+}
+
+static bool body_is_live(PGECollisionBody *body) {
+  return body->active && body->bucketed;
+}
+
+static bool should_test(PGECollisionWorld *this, int id_a, int id_b, uint8_t group_b) {
+  PGECollisionBody *b = &this->bodies[id_b];
+  if(id_a == id_b || !body_is_live(b) || b->group != group_b) {
+    return false;
+  }
+
+  // Within one group, only report each pair one way round
+  return this->bodies[id_a].group != group_b || id_a < id_b;
+}
+
+static bool test_and_report(PGECollisionWorld *this, int id_a, int id_b, PGECollisionPairHandler *handler) {
+  PGECollisionBody *a = &this->bodies[id_a];
+  PGECollisionBody *b = &this->bodies[id_b];
+  if(pge_collision_rectangle_rectangle(&a->aabb, &b->aabb)) {
+    handler(a->context, b->context);
+  }
+
+  // Stop if the handler removed it
+  return a->active;
+}
+
+PGECollisionWorld* pge_collision_world_create(GRect bounds, int cell_size, uint16_t max_bodies) {
+  PGECollisionWorld *this = malloc(sizeof(PGECollisionWorld));
+
+  if(cell_size <= 0) {
+    cell_size = pge_grid_get_tile_size();
+  }
+
+  // Allocate
+  this->bounds = bounds;
+  this->cell_size = cell_size;
+  this->columns = (bounds.size.w + cell_size - 1) / cell_size;
+  this->rows = (bounds.size.h + cell_size - 1) / cell_size;
+  this->max_bodies = max_bodies;
+  this->num_used = 0;
+  this->num_free = 0;
+  this->num_large = 0;
+  this->bodies = calloc(max_bodies, sizeof(PGECollisionBody));
+  this->free_ids = malloc(max_bodies * sizeof(uint16_t));
+  this->large_ids = malloc(max_bodies * sizeof(uint16_t));
+  this->cell_starts = calloc((this->columns * this->rows) + 1, sizeof(uint16_t));
+  this->cell_cursors = malloc(this->columns * this->rows * sizeof(uint16_t));
+  this->cell_entries = malloc(max_bodies * PGE_COLLISION_MAX_CELLS_PER_BODY * sizeof(uint16_t));
+
+  // Finally
+  return this;
+}
+
+void pge_collision_world_destroy(PGECollisionWorld *this) {
+  free(this->cell_entries);
+  free(this->cell_cursors);
+  free(this->cell_starts);
+  free(this->large_ids);
+  free(this->free_ids);
+  free(this->bodies);
+
+  free(this);
+}
+
+int pge_collision_world_add(PGECollisionWorld *this, PGESprite *sprite, uint8_t group, void *context) {
+  int id;
+  if(this->num_free > 0) {
+    this->num_free--;
+    id = this->free_ids[this->num_free];
+  } else if(this->num_used < this->max_bodies) {
+    id = this->num_used;
+    this->num_used++;
+  } else {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Collision world is full!");
+    return -1;
+  }
+
+  this->bodies[id] = (PGECollisionBody){
+    .sprite = sprite,
+    .context = context,
+    .aabb = pge_sprite_get_bounds(sprite),
+    .group = group,
+    .active = true,
+    .bucketed = false
+  };
+  return id;
+}
+
+void pge_collision_world_remove(PGECollisionWorld *this, int body_id) {
+  if(body_id < 0 || body_id >= this->num_used || !this->bodies[body_id].active) {
+    return;
+  }
+
+  // Stale grid entries are ignored until the next update
+  this->bodies[body_id].active = false;
+  this->bodies[body_id].bucketed = false;
+  this->free_ids[this->num_free] = body_id;
+  this->num_free++;
+}
+
+void pge_collision_world_update(PGECollisionWorld *this) {
+  const int num_cells = this->columns * this->rows;
+  memset(this->cell_starts, 0, (num_cells + 1) * sizeof(uint16_t));
+  this->num_large = 0;
+
+  // Cache bounds and count entries per cell
+  for(int id = 0; id < this->num_used; id++) {
+    PGECollisionBody *body = &this->bodies[id];
+    body->bucketed = body->active;
+    if(!body->active) {
+      continue;
+    }
+
+    body->aabb = pge_sprite_get_bounds(body->sprite);
+    int c0 = cell_column(this, body->aabb.origin.x);
+    int c1 = cell_column(this, body->aabb.origin.x + body->aabb.size.w);
+    int r0 = cell_row(this, body->aabb.origin.y);
+    int r1 = cell_row(this, body->aabb.origin.y + body->aabb.size.h);
+    if((c1 - c0 + 1) * (r1 - r0 + 1) > PGE_COLLISION_MAX_CELLS_PER_BODY) {
+      this->large_ids[this->num_large] = id;
+      this->num_large++;
+      continue;
+    }
+
+    for(int r = r0; r <= r1; r++) {
+      for(int c = c0; c <= c1; c++) {
+        this->cell_starts[(r * this->columns) + c + 1]++;
+      }
+    }
+  }
+
+  // Turn counts into runs
+  for(int i = 0; i < num_cells; i++) {
+    this->cell_starts[i + 1] += this->cell_starts[i];
+  }
+  memcpy(this->cell_cursors, this->cell_starts, num_cells * sizeof(uint16_t));
+
+  // Fill the runs
+  for(int id = 0; id < this->num_used; id++) {
+    PGECollisionBody *body = &this->bodies[id];
+    if(!body->active) {
+      continue;
+    }
+
+    int c0 = cell_column(this, body->aabb.origin.x);
+    int c1 = cell_column(this, body->aabb.origin.x + body->aabb.size.w);
+    int r0 = cell_row(this, body->aabb.origin.y);
+    int r1 = cell_row(this, body->aabb.origin.y + body->aabb.size.h);
+    if((c1 - c0 + 1) * (r1 - r0 + 1) > PGE_COLLISION_MAX_CELLS_PER_BODY) {
+      continue;
+    }
+
+    for(int r = r0; r <= r1; r++) {
+      for(int c = c0; c <= c1; c++) {
+        int cell = (r * this->columns) + c;
+        this->cell_entries[this->cell_cursors[cell]] = id;
+        this->cell_cursors[cell]++;
+      }
+    }
+  }
+}
+
+void pge_collision_world_find_pairs(PGECollisionWorld *this, uint8_t group_a, uint8_t group_b, PGECollisionPairHandler *handler) {
+  for(int id_a = 0; id_a < this->num_used; id_a++) {
+    PGECollisionBody *a = &this->bodies[id_a];
+    if(!body_is_live(a) || a->group != group_a) {
+      continue;
+    }
+
+    int c0 = cell_column(this, a->aabb.origin.x);
+    int c1 = cell_column(this, a->aabb.origin.x + a->aabb.size.w);
+    int r0 = cell_row(this, a->aabb.origin.y);
+    int r1 = cell_row(this, a->aabb.origin.y + a->aabb.size.h);
+    if((c1 - c0 + 1) * (r1 - r0 + 1) > PGE_COLLISION_MAX_CELLS_PER_BODY) {
+      // Not bucketed, so test against everything
+      for(int id_b = 0; id_b < this->num_used && a->active; id_b++) {
+        if(should_test(this, id_a, id_b, group_b)) {
+          test_and_report(this, id_a, id_b, handler);
+        }
+      }
+      continue;
+    }
+
+    bool live = true;
+    for(int r = r0; r <= r1 && live; r++) {
+      for(int c = c0; c <= c1 && live; c++) {
+        int cell = (r * this->columns) + c;
+        for(int i = this->cell_starts[cell]; i < this->cell_starts[cell + 1] && live; i++) {
+          int id_b = this->cell_entries[i];
+          if(!should_test(this, id_a, id_b, group_b)) {
+            continue;
+          }
+
+          // Pairs sharing several cells are only tested in the one holding
+          // the top-left of their overlap
+          PGECollisionBody *b = &this->bodies[id_b];
+          int overlap_c = cell_column(this, max(a->aabb.origin.x, b->aabb.origin.x));
+          int overlap_r = cell_row(this, max(a->aabb.origin.y, b->aabb.origin.y));
+          if(overlap_c == c && overlap_r == r) {
+            live = test_and_report(this, id_a, id_b, handler);
+          }
+        }
+      }
+    }
+
+    // Large bodies aren't in any cell
+    for(int i = 0; i < this->num_large && live; i++) {
+      int id_b = this->large_ids[i];
+      if(should_test(this, id_a, id_b, group_b)) {
+        live = test_and_report(this, id_a, id_b, handler);
+      }
+    }
+  }
+}
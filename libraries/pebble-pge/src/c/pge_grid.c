@@ -6,6 +6,10 @@ void pge_grid_set_tile_size(int new_tile_size) {
   s_tile_size = new_tile_size;
 }
 
+int pge_grid_get_tile_size() {
+  return s_tile_size;
+}
+
 GSize pge_grid_get_grid_dimensions() {
   GSize result = GSize(144 / s_tile_size, 168 / s_tile_size);
   if(result.w * s_tile_size > 144) {
@@ -0,0 +1,88 @@
+#include "pge_pool.h"
+
+static void* item_at_slot(PGEPool *this, uint16_t slot) {
+  return this->slab + (slot * this->item_size);
+}
+
+PGEPool* pge_pool_create(size_t item_size, uint16_t capacity) {
+  PGEPool *this = malloc(sizeof(PGEPool));
+
+  // Allocate
+  this->item_size = item_size;
+  this->capacity = capacity;
+  this->count = 0;
+  this->slab = malloc(item_size * capacity);
+  this->slots = malloc(capacity * sizeof(uint16_t));
+  this->positions = malloc(capacity * sizeof(uint16_t));
+
+  // All slots start free
+  for(uint16_t i = 0; i < capacity; i++) {
+    this->slots[i] = i;
+    this->positions[i] = i;
+  }
+
+  // Finally
+  return this;
+}
+
+void pge_pool_destroy(PGEPool *this) {
+  free(this->positions);
+  free(this->slots);
+  free(this->slab);
+
+  free(this);
+}
+
+void* pge_pool_acquire(PGEPool *this) {
+  if(this->count == this->capacity) {
+    return NULL;
+  }
+
+  // First free slot is just after the live ones
+  uint16_t slot = this->slots[this->count];
+  this->count++;
+
+  void *item = item_at_slot(this, slot);
+  memset(item, 0, this->item_size);
+  return item;
+}
+
+void pge_pool_release(PGEPool *this, void *item) {
+  uint8_t *bytes = item;
+  if(bytes < this->slab || bytes >= this->slab + (this->capacity * this->item_size)
+  || (bytes - this->slab) % this->item_size != 0) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Item does not belong to this pool!");
+    return;
+  }
+  uint16_t slot = (bytes - this->slab) / this->item_size;
+
+  uint16_t position = this->positions[slot];
+  if(position >= this->count) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Item already released!");
+    return;
+  }
+
+  // Move the last live slot into the gap, freed slot goes just after
+  this->count--;
+  uint16_t last_slot = this->slots[this->count];
+  this->slots[position] = last_slot;
+  this->positions[last_slot] = position;
+  this->slots[this->count] = slot;
+  this->positions[slot] = this->count;
+}
+
+void pge_pool_clear(PGEPool *this) {
+  this->count = 0;
+}
+
+int pge_pool_get_count(PGEPool *this) {
+  return this->count;
+}
+
+int pge_pool_get_capacity(PGEPool *this) {
+  return this->capacity;
+}
+
+void* pge_pool_get(PGEPool *this, int index) {
+  return item_at_slot(this, this->slots[index]);
+}
@@ -0,0 +1,189 @@
+#include "pge_scene.h"
+
+static int get_num_cacheable(PGEScene *this) {
+  // Static layers up to the first visible dynamic one
+  for(int i = 0; i < this->num_layers; i++) {
+    if(!this->layers[i].is_static && !this->layers[i].is_hidden) {
+      return i;
+    }
+  }
+  return this->num_layers;
+}
+
+static void invalidate(PGEScene *this) {
+  this->cache_valid = false;
+
+  // The cache is rebuilt from a whole fresh screen
+  pge_mark_all_dirty();
+}
+
+static void draw_layers(PGEScene *this, GContext *ctx, int from, int to) {
+  for(int i = from; i < to; i++) {
+    PGESceneLayer *layer = &this->layers[i];
+    if(!layer->is_hidden) {
+      layer->render_handler(ctx, layer->context);
+    }
+  }
+}
+
+#if defined(PBL_BW)
+static void copy_span(uint8_t *row, const uint8_t *src, int x0, int x1) {
+  // Pixels x0 to x1 inclusive, one bit each, with partial bytes at either end
+  int b0 = x0 / 8;
+  int b1 = x1 / 8;
+  uint8_t first = 0xFF << (x0 % 8);
+  uint8_t last = 0xFF >> (7 - (x1 % 8));
+  if(b0 == b1) {
+    first &= last;
+  }
+
+  row[b0] = (row[b0] & ~first) | (src[b0] & first);
+  if(b1 > b0) {
+    if(b1 - b0 > 1) {
+      memcpy(&row[b0 + 1], &src[b0 + 1], b1 - b0 - 1);
+    }
+    row[b1] = (row[b1] & ~last) | (src[b1] & last);
+  }
+}
+#elif defined(PBL_COLOR)
+static void copy_span(uint8_t *row, const uint8_t *src, int x0, int x1) {
+  memcpy(&row[x0], &src[x0], x1 - x0 + 1);
+}
+#endif
+
+static void copy_rect(GBitmap *dest, GBitmap *src, GRect rect) {
+  for(int y = rect.origin.y; y < rect.origin.y + rect.size.h; y++) {
+    GBitmapDataRowInfo dest_info = gbitmap_get_data_row_info(dest, y);
+    GBitmapDataRowInfo src_info = gbitmap_get_data_row_info(src, y);
+    int x0 = MAX(rect.origin.x, dest_info.min_x);
+    int x1 = MIN(rect.origin.x + rect.size.w - 1, dest_info.max_x);
+    if(x0 <= x1) {
+      copy_span(dest_info.data, src_info.data, x0, x1);
+    }
+  }
+}
+
+static void save_cache(PGEScene *this, GContext *ctx) {
+  GBitmap *fb = graphics_capture_frame_buffer(ctx);
+  if(!fb) {
+    return;
+  }
+
+  GRect bounds = gbitmap_get_bounds(fb);
+  if(!this->cache && !this->cache_failed) {
+    this->cache = gbitmap_create_blank(bounds.size, gbitmap_get_format(fb));
+    if(!this->cache) {
+      APP_LOG(APP_LOG_LEVEL_ERROR, "Not enough memory for scene cache, drawing every frame");
+      this->cache_failed = true;
+    }
+  }
+  if(this->cache) {
+    copy_rect(this->cache, fb, bounds);
+    this->cache_valid = true;
+  }
+  graphics_release_frame_buffer(ctx, fb);
+}
+
+static bool restore_cache(PGEScene *this, GContext *ctx) {
+  GBitmap *fb = graphics_capture_frame_buffer(ctx);
+  if(!fb) {
+    return false;
+  }
+
+  if(pge_get_dirty_rects_enabled()) {
+    // Only where the frame is being redrawn
+    const GRect *rects;
+    int num_rects = pge_get_dirty_rects(&rects);
+    for(int i = 0; i < num_rects; i++) {
+      copy_rect(fb, this->cache, rects[i]);
+    }
+  } else {
+    copy_rect(fb, this->cache, gbitmap_get_bounds(fb));
+  }
+  graphics_release_frame_buffer(ctx, fb);
+  return true;
+}
+
+PGEScene* pge_scene_create() {
+  PGEScene *this = malloc(sizeof(PGEScene));
+
+  // Allocate
+  this->num_layers = 0;
+  this->cache = NULL;
+  this->num_cached = 0;
+  this->cache_valid = false;
+  this->cache_failed = false;
+
+  // Finally
+  return this;
+}
+
+void pge_scene_destroy(PGEScene *this) {
+  if(this->cache) {
+    gbitmap_destroy(this->cache);
+  }
+
+  free(this);
+}
+
+int pge_scene_add_layer(PGEScene *this, PGESceneLayerRenderHandler *render_handler, void *context, bool is_static) {
+  if(this->num_layers == PGE_SCENE_MAX_LAYERS) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Scene is full!");
+    return -1;
+  }
+
+  this->layers[this->num_layers] = (PGESceneLayer) {
+    .render_handler = render_handler,
+    .context = context,
+    .is_static = is_static,
+    .is_hidden = false
+  };
+  this->num_layers++;
+  invalidate(this);
+  return this->num_layers - 1;
+}
+
+void pge_scene_set_layer_hidden(PGEScene *this, int layer, bool hidden) {
+  if(layer < 0 || layer >= this->num_layers || this->layers[layer].is_hidden == hidden) {
+    return;
+  }
+
+  this->layers[layer].is_hidden = hidden;
+  if(this->layers[layer].is_static) {
+    invalidate(this);
+  } else {
+    // Showing or hiding a dynamic layer moves where caching stops
+    if(get_num_cacheable(this) != this->num_cached) {
+      invalidate(this);
+    }
+    pge_mark_all_dirty();
+  }
+}
+
+void pge_scene_invalidate_layer(PGEScene *this, int layer) {
+  if(layer < 0 || layer >= this->num_layers || !this->layers[layer].is_static) {
+    // Dynamic layers are drawn every frame anyway
+    return;
+  }
+
+  invalidate(this);
+}
+
+void pge_scene_draw(PGEScene *this, GContext *ctx) {
+  int num_cacheable = get_num_cacheable(this);
+  if(num_cacheable != this->num_cached) {
+    this->num_cached = num_cacheable;
+    this->cache_valid = false;
+  }
+
+  if(this->num_cached > 0) {
+    if(!this->cache_valid || !restore_cache(this, ctx)) {
+      // Draw the static layers once and keep the result
+      draw_layers(this, ctx, 0, this->num_cached);
+      save_cache(this, ctx);
+    }
+  }
+
+  // Everything above is drawn every frame
+  draw_layers(this, ctx, this->num_cached, this->num_layers);
+}
@@ -1,39 +1,275 @@
 #include "pge_sprite.h"
 #include "pge_collision.h"
+#include "pge.h"
+
+/************************************ Atlas ***********************************/
+
+static GBitmap* atlas_acquire_frame(PGESpriteAtlas *this, int frame) {
+  PGESpriteAtlasFrame *entry = &this->frames[frame];
+  if(!entry->bitmap) {
+    // Shares pixel data with the sheet, only the header is allocated
+    entry->bitmap = gbitmap_create_as_sub_bitmap(this->sheet, GRect(
+      (frame % this->columns) * this->frame_size.w,
+      (frame / this->columns) * this->frame_size.h,
+      this->frame_size.w, this->frame_size.h));
+    if(!entry->bitmap) {
+      APP_LOG(APP_LOG_LEVEL_ERROR, "Not enough memory for atlas frame %d", frame);
+      return NULL;
+    }
+  }
+  entry->ref_count++;
+  return entry->bitmap;
+}
+
+static void atlas_release_frame(PGESpriteAtlas *this, int frame) {
+  // Kept cached until trimmed, so animating doesn't churn the heap
+  if(this->frames[frame].ref_count > 0) {
+    this->frames[frame].ref_count--;
+  }
+}
+
+static void atlas_release(PGESpriteAtlas *this) {
+  this->ref_count--;
+  if(this->ref_count > 0) {
+    return;
+  }
+
+  for(int i = 0; i < this->num_frames; i++) {
+    if(this->frames[i].bitmap) {
+      gbitmap_destroy(this->frames[i].bitmap);
+    }
+  }
+  free(this->frames);
+  gbitmap_destroy(this->sheet);
+  free(this);
+}
+
+static bool atlas_frame_is_valid(PGESpriteAtlas *this, int frame) {
+  if(frame < 0 || frame >= this->num_frames) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Atlas frame %d out of range (%d frames)", frame, this->num_frames);
+    return false;
+  }
+  return true;
+}
+
+PGESpriteAtlas* pge_sprite_atlas_create(int sheet_resource_id, GSize frame_size) {
+  GBitmap *sheet = gbitmap_create_with_resource(sheet_resource_id);
+  if(!sheet) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Could not load atlas sheet %d", sheet_resource_id);
+    return NULL;
+  }
+
+  GSize sheet_size = gbitmap_get_bounds(sheet).size;
+  if(frame_size.w == 0 || frame_size.h == 0) {
+    // Whole image is one frame
+    frame_size = sheet_size;
+  }
+  if(frame_size.w <= 0 || frame_size.h <= 0
+  || frame_size.w > sheet_size.w || frame_size.h > sheet_size.h) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Atlas frame size %dx%d does not fit sheet %dx%d",
+      frame_size.w, frame_size.h, sheet_size.w, sheet_size.h);
+    gbitmap_destroy(sheet);
+    return NULL;
+  }
+
+  // Allocate
+  PGESpriteAtlas *this = malloc(sizeof(PGESpriteAtlas));
+  int columns = sheet_size.w / frame_size.w;
+  int num_frames = columns * (sheet_size.h / frame_size.h);
+  PGESpriteAtlasFrame *frames = calloc(num_frames, sizeof(PGESpriteAtlasFrame));
+  if(!this || !frames) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Not enough memory for atlas");
+    free(this);
+    free(frames);
+    gbitmap_destroy(sheet);
+    return NULL;
+  }
+  this->sheet = sheet;
+  this->frame_size = frame_size;
+  this->columns = columns;
+  this->num_frames = num_frames;
+  this->frames = frames;
+
+  // Owner's reference
+  this->ref_count = 1;
+
+  // Finally
+  return this;
+}
+
+void pge_sprite_atlas_destroy(PGESpriteAtlas *this) {
+  atlas_release(this);
+}
+
+int pge_sprite_atlas_get_num_frames(PGESpriteAtlas *this) {
+  return this->num_frames;
+}
+
+void pge_sprite_atlas_trim(PGESpriteAtlas *this) {
+  for(int i = 0; i < this->num_frames; i++) {
+    PGESpriteAtlasFrame *entry = &this->frames[i];
+    if(entry->bitmap && entry->ref_count == 0) {
+      gbitmap_destroy(entry->bitmap);
+      entry->bitmap = NULL;
+    }
+  }
+}
+
+/*********************************** Sprite ***********************************/
+
+static void set_bitmap(PGESprite *this, GBitmap *bitmap) {
+  this->bitmap = bitmap;
+
+  // Cache the size so bounds don't need to be looked up each time
+#if defined(PBL_SDK_2)
+  this->size = bitmap->bounds.size;
+#elif defined(PBL_SDK_3)
+  this->size = gbitmap_get_bounds(bitmap).size;
+#endif
+}
+
+static void release_bitmap(PGESprite *this) {
+  if(this->atlas) {
+    atlas_release_frame(this->atlas, this->atlas_frame);
+    atlas_release(this->atlas);
+    this->atlas = NULL;
+  } else {
+    gbitmap_destroy(this->bitmap);
+  }
+  this->bitmap = NULL;
+  this->size = GSize(0, 0);
+}
+
+void pge_sprite_init(PGESprite *this, GPoint position, int initial_resource_id) {
+  set_bitmap(this, gbitmap_create_with_resource(initial_resource_id));
+  this->position = position;
+  this->atlas = NULL;
+  this->atlas_frame = 0;
+  pge_mark_dirty_rect(pge_sprite_get_bounds(this));
+}
+
+bool pge_sprite_init_with_atlas(PGESprite *this, GPoint position, PGESpriteAtlas *atlas, int initial_frame) {
+  if(!atlas_frame_is_valid(atlas, initial_frame)) {
+    return false;
+  }
+
+  // Share the atlas and its frame
+  atlas->ref_count++;
+  GBitmap *bitmap = atlas_acquire_frame(atlas, initial_frame);
+  if(!bitmap) {
+    atlas->ref_count--;
+    return false;
+  }
+  this->atlas = atlas;
+  this->atlas_frame = initial_frame;
+  set_bitmap(this, bitmap);
+  this->position = position;
+  pge_mark_dirty_rect(pge_sprite_get_bounds(this));
+  return true;
+}
+
+void pge_sprite_deinit(PGESprite *this) {
+  // Erase from the screen
+  pge_mark_dirty_rect(pge_sprite_get_bounds(this));
+  release_bitmap(this);
+}
 
 PGESprite* pge_sprite_create(GPoint position, int initial_resource_id) {
   PGESprite *this = malloc(sizeof(PGESprite));
 
   // Allocate
-  this->bitmap = gbitmap_create_with_resource(initial_resource_id);
-  this->position = position;
+  pge_sprite_init(this, position, initial_resource_id);
+
+  // Finally
+  return this;
+}
+
+PGESprite* pge_sprite_create_with_atlas(GPoint position, PGESpriteAtlas *atlas, int initial_frame) {
+  PGESprite *this = malloc(sizeof(PGESprite));
+
+  // Allocate
+  if(!pge_sprite_init_with_atlas(this, position, atlas, initial_frame)) {
+    free(this);
+    return NULL;
+  }
 
   // Finally
   return this;
 }
 
 void pge_sprite_destroy(PGESprite *this) {
-  gbitmap_destroy(this->bitmap);
+  pge_sprite_deinit(this);
 
   free(this);
 }
 
 void pge_sprite_set_anim_frame(PGESprite *this, int resource_id) {
-  gbitmap_destroy(this->bitmap);
-  this->bitmap = gbitmap_create_with_resource(resource_id);
+  pge_mark_dirty_rect(pge_sprite_get_bounds(this));
+  release_bitmap(this);
+  set_bitmap(this, gbitmap_create_with_resource(resource_id));
+  pge_mark_dirty_rect(pge_sprite_get_bounds(this));
+}
+
+void pge_sprite_set_atlas_frame(PGESprite *this, int frame) {
+  if(!this->atlas) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Sprite was not created with an atlas!");
+    return;
+  }
+  if(frame == this->atlas_frame || !atlas_frame_is_valid(this->atlas, frame)) {
+    return;
+  }
+
+  GBitmap *bitmap = atlas_acquire_frame(this->atlas, frame);
+  if(!bitmap) {
+    // Keep showing the current frame
+    return;
+  }
+
+  pge_mark_dirty_rect(pge_sprite_get_bounds(this));
+  atlas_release_frame(this->atlas, this->atlas_frame);
+  this->atlas_frame = frame;
+  set_bitmap(this, bitmap);
+  pge_mark_dirty_rect(pge_sprite_get_bounds(this));
 }
 
 void pge_sprite_draw(PGESprite *this, GContext *ctx) {
-#if defined(PBL_SDK_2)
-  GRect bounds = this->bitmap->bounds;
-#elif defined(PBL_SDK_3)
-  GRect bounds = gbitmap_get_bounds(this->bitmap);
+  GRect frame = pge_sprite_get_bounds(this);
+#if defined(PBL_SDK_3)
+  if(pge_get_dirty_rects_enabled()) {
+    GRect bounds = gbitmap_get_bounds(this->bitmap);
+
+    // Only draw the parts inside regions being redrawn, to not cover others
+    const GRect *rects;
+    int num_rects = pge_get_dirty_rects(&rects);
+    for(int i = 0; i < num_rects; i++) {
+      GRect clipped = frame;
+      grect_clip(&clipped, &rects[i]);
+      if(grect_is_empty(&clipped)) {
+        continue;
+      }
+
+      gbitmap_set_bounds(this->bitmap, GRect(
+        bounds.origin.x + (clipped.origin.x - frame.origin.x),
+        bounds.origin.y + (clipped.origin.y - frame.origin.y),
+        clipped.size.w, clipped.size.h));
+      graphics_draw_bitmap_in_rect(ctx, this->bitmap, clipped);
+    }
+    gbitmap_set_bounds(this->bitmap, bounds);
+    return;
+  }
 #endif
-  graphics_draw_bitmap_in_rect(ctx, this->bitmap, GRect(this->position.x, this->position.y, bounds.size.w, bounds.size.h));
+  graphics_draw_bitmap_in_rect(ctx, this->bitmap, frame);
 }
 
 void pge_sprite_set_position(PGESprite *this, GPoint new_position) {
+  if(gpoint_equal(&this->position, &new_position)) {
+    return;
+  }
+
+  // Both where it was and where it will be need redrawing
+  pge_mark_dirty_rect(pge_sprite_get_bounds(this));
   this->position = new_position;
+  pge_mark_dirty_rect(pge_sprite_get_bounds(this));
 }
 
 GPoint pge_sprite_get_position(PGESprite *this) {
@@ -48,31 +284,17 @@ void pge_sprite_move(PGESprite *this, int dx, int dy) {
 }
 
 bool pge_check_collision(PGESprite* sprite1, PGESprite *sprite2) {
-#if defined(PBL_SDK_2)
-  GRect bounds1 = sprite1->bitmap->bounds;
-  GRect bounds2 = sprite2->bitmap->bounds;
-#elif defined(PBL_SDK_3)
-  GRect bounds1 = gbitmap_get_bounds(sprite1->bitmap);
-  GRect bounds2 = gbitmap_get_bounds(sprite2->bitmap);
-#endif
-
-  GRect rect_a = (GRect){
-    {sprite1->position.x, sprite1->position.y}, 
-    {bounds1.size.w, bounds1.size.h}};
-
-  GRect rect_b = (GRect){
-    {sprite2->position.x, sprite2->position.y}, 
-    {bounds2.size.w, bounds2.size.h}};
-
-  // Test each corner of the other rect
+  GRect rect_a = pge_sprite_get_bounds(sprite1);
+  GRect rect_b = pge_sprite_get_bounds(sprite2);
   return pge_collision_rectangle_rectangle(&rect_a, &rect_b);
 }
 
+bool pge_check_swept_collision(PGESprite *sprite1, GPoint velocity1, PGESprite *sprite2, GPoint velocity2, int32_t *time_of_impact) {
+  GRect rect_a = pge_sprite_get_bounds(sprite1);
+  GRect rect_b = pge_sprite_get_bounds(sprite2);
+  return pge_collision_swept_rectangle_rectangle(&rect_a, velocity1, &rect_b, velocity2, time_of_impact);
+}
+
 GRect pge_sprite_get_bounds(PGESprite *this) {
-#if defined(PBL_SDK_2)
-  GRect bounds = this->bitmap->bounds;
-#elif defined(PBL_SDK_3)
-  GRect bounds = gbitmap_get_bounds(this->bitmap);
-#endif
-  return GRect(this->position.x, this->position.y, bounds.size.w, bounds.size.h);
+  return GRect(this->position.x, this->position.y, this->size.w, this->size.h);
 }
\ No newline at end of file
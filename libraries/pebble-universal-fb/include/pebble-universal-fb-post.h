@@ -0,0 +1,46 @@
+/**
+ * Framebuffer post-processing add-on for universal-fb
+ *
+ * Runs a chain of effects over the framebuffer in a single pass, each effect
+ * seeing the result of those before it. Every framebuffer row is read and
+ * written once however many effects there are.
+ */
+
+#pragma once
+
+#include <pebble.h>
+
+// Most effects in one chain
+#define UNIVERSAL_FB_POST_MAX_EFFECTS 8
+
+// Furthest a drop shadow can fall vertically
+#define UNIVERSAL_FB_POST_MAX_RADIUS 8
+
+typedef enum {
+  // Pixels with match on the two rows above and below become color
+  UniversalFBEffectFillGaps = 0,
+  // Pixels next to one of match (but not match themselves) become color
+  UniversalFBEffectOutline,
+  // Pixels not match whose pixel at -offset is match become color
+  UniversalFBEffectDropShadow,
+  // Every other pixel of match becomes color, in a checkerboard
+  UniversalFBEffectDither,
+  // Pixels of match become color and vice versa
+  UniversalFBEffectInvert
+} UniversalFBEffectType;
+
+typedef struct {
+  UniversalFBEffectType type;
+  GColor match;   // Color the effect looks for
+  GColor color;   // Color the effect draws
+  GPoint offset;  // Where the shadow falls, UniversalFBEffectDropShadow only
+} UniversalFBEffect;
+
+/**
+ * Apply num_effects effects to the framebuffer, in order, in one pass.
+ * Only GColorWhite and GColorBlack are meaningful on black and white.
+ *
+ * Note: Keeps a few copies of rows for effects that look at the rows around
+ * each pixel, which are allocated for the duration of the call.
+ */
+void universal_fb_post_process(GBitmap *fb, const UniversalFBEffect *effects, int num_effects);
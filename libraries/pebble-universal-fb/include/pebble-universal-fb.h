@@ -18,3 +18,39 @@ void universal_fb_set_pixel_color(GBitmapDataRowInfo info, GRect bounds, GPoint
  * c2 will only replace c1. No other inversion will occur.
  */
 void universal_fb_swap_colors(GBitmap *fb, GRect bounds, GColor c1, GColor c2);
+
+/**
+ * Fill pixels x0 to x1 inclusive of a row with a color, clipped to the row.
+ * On black and white, only GColorWhite sets pixels white.
+ */
+void universal_fb_fill_span(GBitmapDataRowInfo info, int x0, int x1, GColor color);
+
+/**
+ * Fill a rectangle with a color, clipped to the bitmap and each row.
+ */
+void universal_fb_fill_rect(GBitmap *fb, GRect rect, GColor color);
+
+/**
+ * Copy src_rect of src to dest in fb, clipped to both bitmaps.
+ * src must have the same format as fb (or GBitmapFormat8Bit on color). It may
+ * be fb itself, but overlapping areas must then be on different rows.
+ */
+void universal_fb_copy_rect(GBitmap *fb, GBitmap *src, GRect src_rect, GPoint dest);
+
+/**
+ * As universal_fb_copy_rect(), but only copies pixels set in mask, a
+ * GBitmapFormat1Bit bitmap laid out the same as src.
+ */
+void universal_fb_blit_masked(GBitmap *fb, GBitmap *src, GBitmap *mask, GRect src_rect, GPoint dest);
+
+/**
+ * Draw src_rect of src, in any format, to dest in fb in a single pass.
+ * - If fg is GColorClear, src colors are drawn as they are.
+ * - Otherwise each pixel is tinted by its brightness: from bg for black to fg
+ *   for white. If bg is also GColorClear, black is transparent and brightness
+ *   sets how opaque fg is, which suits white-on-black images and text.
+ * On color, partly transparent pixels are blended with what is already there.
+ * On black and white, pixels at least 2/3 opaque are drawn, as black or white
+ * by brightness.
+ */
+void universal_fb_blit_tinted(GBitmap *fb, GBitmap *src, GRect src_rect, GPoint dest, GColor fg, GColor bg);
@@ -0,0 +1,259 @@
+#include "pebble-universal-fb-post.h"
+
+// One effect in the chain, holding the rows of its input it still needs
+typedef struct {
+  const UniversalFBEffect *effect;
+  int radius;        // Rows needed above and below each row it processes
+  uint8_t *rows;     // (radius * 2) + 1 input rows, stored at y modulo that
+  uint8_t *output;   // The row being processed
+} Stage;
+
+typedef struct {
+  GBitmap *fb;
+  int height;
+  int row_bytes;
+  Stage stages[UNIVERSAL_FB_POST_MAX_EFFECTS];
+  int num_stages;
+} Pipeline;
+
+static int get_radius(const UniversalFBEffect *effect) {
+  switch(effect->type) {
+    case UniversalFBEffectFillGaps:
+      return 2;
+    case UniversalFBEffectOutline:
+      return 1;
+    case UniversalFBEffectDropShadow:
+      return (effect->offset.y < 0) ? -effect->offset.y : effect->offset.y;
+    default:
+      return 0;
+  }
+}
+
+#if defined(PBL_BW)
+/**
+ * 8 pixels of a row from x, set where they are match. Outside the row counts
+ * as not match.
+ */
+static uint8_t read_match_bits(const uint8_t *row, int row_bytes, int x, uint8_t invert) {
+  if(!row) {
+    return 0;
+  }
+
+  // Round towards negative infinity, to allow reading left of the row
+  int byte = (x >= 0) ? x / 8 : -((7 - x) / 8);
+  int shift = x - (byte * 8);
+  uint8_t lo = (byte >= 0 && byte < row_bytes) ? row[byte] ^ invert : 0;
+  uint8_t hi = (byte + 1 >= 0 && byte + 1 < row_bytes) ? row[byte + 1] ^ invert : 0;
+  return (shift == 0) ? lo : (uint8_t)((lo >> shift) | (hi << (8 - shift)));
+}
+
+/**
+ * Work on whole bytes, with window[radius] as the row being processed
+ */
+static void run_effect(const UniversalFBEffect *effect, const uint8_t **window, int radius,
+                       uint8_t *out, int y, int row_bytes) {
+  const uint8_t *row = window[radius];
+  uint8_t invert = gcolor_equal(effect->match, GColorWhite) ? 0x00 : 0xFF;
+  uint8_t color = gcolor_equal(effect->color, GColorWhite) ? 0xFF : 0x00;
+
+  for(int i = 0; i < row_bytes; i++) {
+    int x = i * 8;
+    uint8_t match = row[i] ^ invert;
+    uint8_t bits = 0;
+    switch(effect->type) {
+      case UniversalFBEffectFillGaps:
+        bits = read_match_bits(window[radius - 2], row_bytes, x, invert)
+          & read_match_bits(window[radius - 1], row_bytes, x, invert)
+          & read_match_bits(window[radius + 1], row_bytes, x, invert)
+          & read_match_bits(window[radius + 2], row_bytes, x, invert);
+        break;
+      case UniversalFBEffectOutline:
+        bits = ~match & (read_match_bits(window[radius - 1], row_bytes, x, invert)
+          | read_match_bits(window[radius + 1], row_bytes, x, invert)
+          | read_match_bits(row, row_bytes, x - 1, invert)
+          | read_match_bits(row, row_bytes, x + 1, invert));
+        break;
+      case UniversalFBEffectDropShadow:
+        bits = ~match & read_match_bits(window[radius - effect->offset.y], row_bytes,
+          x - effect->offset.x, invert);
+        break;
+      case UniversalFBEffectDither:
+        bits = match & ((y % 2 == 0) ? 0x55 : 0xAA);
+        break;
+      case UniversalFBEffectInvert: {
+        // Both ways at once
+        uint8_t other = row[i] ^ (color ^ 0xFF);
+        out[i] = (row[i] & ~(match | other)) | (color & match) | ((invert ^ 0xFF) & other);
+        continue;
+      }
+    }
+    out[i] = (row[i] & ~bits) | (color & bits);
+  }
+}
+#elif defined(PBL_COLOR)
+static uint8_t read_pixel(const uint8_t *row, int row_bytes, int x) {
+  // Outside the row or display is GColorClear, which never matches
+  return (row && x >= 0 && x < row_bytes) ? row[x] : GColorClearARGB8;
+}
+
+/**
+ * Work pixel by pixel, with window[radius] as the row being processed
+ */
+static void run_effect(const UniversalFBEffect *effect, const uint8_t **window, int radius,
+                       uint8_t *out, int y, int row_bytes) {
+  const uint8_t *row = window[radius];
+  uint8_t match = effect->match.argb;
+  uint8_t color = effect->color.argb;
+
+  for(int x = 0; x < row_bytes; x++) {
+    uint8_t pixel = row[x];
+    if(pixel == GColorClearARGB8) {
+      // Outside a round display, keep it that way for the next effect
+      out[x] = pixel;
+      continue;
+    }
+
+    bool draw = false;
+    switch(effect->type) {
+      case UniversalFBEffectFillGaps:
+        draw = read_pixel(window[radius - 2], row_bytes, x) == match
+          && read_pixel(window[radius - 1], row_bytes, x) == match
+          && read_pixel(window[radius + 1], row_bytes, x) == match
+          && read_pixel(window[radius + 2], row_bytes, x) == match;
+        break;
+      case UniversalFBEffectOutline:
+        draw = pixel != match && (read_pixel(window[radius - 1], row_bytes, x) == match
+          || read_pixel(window[radius + 1], row_bytes, x) == match
+          || read_pixel(row, row_bytes, x - 1) == match
+          || read_pixel(row, row_bytes, x + 1) == match);
+        break;
+      case UniversalFBEffectDropShadow:
+        draw = pixel != match
+          && read_pixel(window[radius - effect->offset.y], row_bytes, x - effect->offset.x) == match;
+        break;
+      case UniversalFBEffectDither:
+        draw = pixel == match && (x + y) % 2 == 0;
+        break;
+      case UniversalFBEffectInvert:
+        // Both ways at once
+        out[x] = (pixel == match) ? color : ((pixel == color) ? match : pixel);
+        continue;
+    }
+    out[x] = draw ? color : pixel;
+  }
+}
+#endif
+
+/**
+ * Give stage s its input row y, or NULL once past the last row, and pass on
+ * every row it can then finish
+ */
+static void push_row(Pipeline *this, int s, int y, const uint8_t *data) {
+  if(s == this->num_stages) {
+    if(data) {
+      // Done with every effect
+      GBitmapDataRowInfo info = gbitmap_get_data_row_info(this->fb, y);
+#if defined(PBL_COLOR)
+      memcpy(&info.data[info.min_x], &data[info.min_x], info.max_x - info.min_x + 1);
+#elif defined(PBL_BW)
+      memcpy(info.data, data, this->row_bytes);
+#endif
+    }
+    return;
+  }
+
+  Stage *stage = &this->stages[s];
+  int num_rows = (stage->radius * 2) + 1;
+  if(data) {
+    memcpy(&stage->rows[(y % num_rows) * this->row_bytes], data, this->row_bytes);
+  }
+
+  // Finish the row radius above, now everything around it has arrived
+  int out_y = y - stage->radius;
+  if(out_y < 0) {
+    return;
+  }
+  if(out_y >= this->height) {
+    push_row(this, s + 1, out_y, NULL);
+    return;
+  }
+
+  const uint8_t *window[(UNIVERSAL_FB_POST_MAX_RADIUS * 2) + 1];
+  for(int i = 0; i < num_rows; i++) {
+    int row_y = out_y - stage->radius + i;
+    window[i] = (row_y >= 0 && row_y < this->height)
+      ? &stage->rows[(row_y % num_rows) * this->row_bytes] : NULL;
+  }
+  run_effect(stage->effect, window, stage->radius, stage->output, out_y, this->row_bytes);
+  push_row(this, s + 1, out_y, stage->output);
+}
+
+void universal_fb_post_process(GBitmap *fb, const UniversalFBEffect *effects, int num_effects) {
+  if(num_effects > UNIVERSAL_FB_POST_MAX_EFFECTS) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "universal_fb: too many effects!");
+    return;
+  }
+
+  GSize size = gbitmap_get_bounds(fb).size;
+  Pipeline this = {
+    .fb = fb,
+    .height = size.h,
+    .row_bytes = PBL_IF_COLOR_ELSE(size.w, (size.w + 7) / 8),
+    .num_stages = num_effects
+  };
+
+  // Room for each stage's window of rows and its output row
+  int total_rows = 0;
+  for(int i = 0; i < num_effects; i++) {
+    int radius = get_radius(&effects[i]);
+    if(radius > UNIVERSAL_FB_POST_MAX_RADIUS) {
+      APP_LOG(APP_LOG_LEVEL_ERROR, "universal_fb: effect %d reaches too far!", i);
+      return;
+    }
+    this.stages[i] = (Stage) {
+      .effect = &effects[i],
+      .radius = radius
+    };
+    total_rows += (radius * 2) + 2;
+  }
+  uint8_t *memory = malloc(total_rows * this.row_bytes);
+  uint8_t *input = malloc(this.row_bytes);
+  if(!memory || !input) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "universal_fb: not enough memory to post process");
+    free(memory);
+    free(input);
+    return;
+  }
+  uint8_t *next = memory;
+  for(int i = 0; i < num_effects; i++) {
+    this.stages[i].rows = next;
+    next += ((this.stages[i].radius * 2) + 1) * this.row_bytes;
+    this.stages[i].output = next;
+    next += this.row_bytes;
+  }
+
+  // Each row is read once, and flows through every stage before it is written
+  int latency = 0;
+  for(int i = 0; i < num_effects; i++) {
+    latency += this.stages[i].radius;
+  }
+  for(int y = 0; y < size.h + latency; y++) {
+    if(y >= size.h) {
+      push_row(&this, 0, y, NULL);
+      continue;
+    }
+
+    GBitmapDataRowInfo info = gbitmap_get_data_row_info(fb, y);
+#if defined(PBL_COLOR)
+    // Pixels outside a round display are left clear
+    memset(input, GColorClearARGB8, this.row_bytes);
+    memcpy(&input[info.min_x], &info.data[info.min_x], info.max_x - info.min_x + 1);
+#elif defined(PBL_BW)
+    memcpy(input, info.data, this.row_bytes);
+#endif
+    push_row(&this, 0, y, input);
+  }
+
+  free(memory);
+  free(input);
+}
@@ -14,13 +14,231 @@ static bool byte_get_bit(uint8_t *byte, uint8_t bit) {
 static void byte_set_bit(uint8_t *byte, uint8_t bit, uint8_t value) {
   *byte ^= (-value ^ *byte) & (1 << bit);
 }
+
+/**
+ * Bits of the byte holding pixels x0 to x1 inclusive, which must share a byte
+ */
+static uint8_t get_byte_mask(int x0, int x1) {
+  return (uint8_t)((0xFF << (x0 % 8)) & (0xFF >> (7 - (x1 % 8))));
+}
+
+/**
+ * Read count (up to 8) pixels of a 1-bit row from x, into the lowest bits
+ */
+static uint8_t read_bits(const uint8_t *row, int x, int count) {
+  uint8_t bits = row[x / 8] >> (x % 8);
+  if((x % 8) + count > 8) {
+    bits |= row[(x / 8) + 1] << (8 - (x % 8));
+  }
+  return bits;
+}
+
+/**
+ * Copy pixels x0 to x1 inclusive of a 1-bit row from src starting at src_x,
+ * only where mask (if any) is set. Works a whole byte at a time.
+ */
+static void blit_bits(uint8_t *row, int x0, int x1, const uint8_t *src, int src_x, const uint8_t *mask) {
+  if(!mask && (x0 % 8) == (src_x % 8)) {
+    // Lined up, so whole bytes in between can be copied as they are
+    int b0 = x0 / 8;
+    int b1 = x1 / 8;
+    const uint8_t *from = &src[(src_x / 8) - b0];
+    if(b0 == b1) {
+      uint8_t bits = get_byte_mask(x0, x1);
+      row[b0] = (row[b0] & ~bits) | (from[b0] & bits);
+      return;
+    }
+
+    uint8_t first = get_byte_mask(x0, 7);
+    uint8_t last = get_byte_mask(0, x1);
+    row[b0] = (row[b0] & ~first) | (from[b0] & first);
+    if(b1 - b0 > 1) {
+      memmove(&row[b0 + 1], &from[b0 + 1], b1 - b0 - 1);
+    }
+    row[b1] = (row[b1] & ~last) | (from[b1] & last);
+    return;
+  }
+
+  for(int b = x0 / 8; b <= x1 / 8; b++) {
+    int start = (b * 8 > x0) ? b * 8 : x0;
+    int end = ((b * 8) + 7 < x1) ? (b * 8) + 7 : x1;
+    int count = end - start + 1;
+    int sx = src_x + (start - x0);
+    uint8_t bits = get_byte_mask(start, end);
+    if(mask) {
+      bits &= read_bits(mask, sx, count) << (start % 8);
+    }
+    row[b] = (row[b] & ~bits) | ((read_bits(src, sx, count) << (start % 8)) & bits);
+  }
+}
+#endif
+
+/**
+ * Find one row of src_rect drawn at dest, and its span x0 to x1 inclusive in
+ * fb, clipped to both bitmaps. Returns false if none of it is visible.
+ */
+static bool clip_blit_row(GBitmap *fb, GBitmap *src, GRect src_rect, GPoint dest, int row,
+                          GBitmapDataRowInfo *info, GBitmapDataRowInfo *src_info, int *x0, int *x1) {
+  GRect fb_bounds = gbitmap_get_bounds(fb);
+  GRect src_bounds = gbitmap_get_bounds(src);
+  int y = dest.y + row;
+  int src_y = src_rect.origin.y + row;
+  if(y < fb_bounds.origin.y || y >= fb_bounds.origin.y + fb_bounds.size.h
+  || src_y < src_bounds.origin.y || src_y >= src_bounds.origin.y + src_bounds.size.h) {
+    return false;
+  }
+
+  *info = gbitmap_get_data_row_info(fb, y);
+  *src_info = gbitmap_get_data_row_info(src, src_y);
+  int offset = src_rect.origin.x - dest.x;
+  *x0 = dest.x;
+  *x1 = dest.x + src_rect.size.w - 1;
+  *x0 = (*x0 < info->min_x) ? info->min_x : *x0;
+  *x0 = (*x0 + offset < src_info->min_x) ? src_info->min_x - offset : *x0;
+  *x1 = (*x1 > info->max_x) ? info->max_x : *x1;
+  *x1 = (*x1 + offset > src_info->max_x) ? src_info->max_x - offset : *x1;
+  return *x0 <= *x1;
+}
+
+/**
+ * Copy or mask one row of src_rect into fb at dest
+ */
+static void blit_row(GBitmap *fb, GBitmap *src, GBitmap *mask, GRect src_rect, GPoint dest, int row) {
+  GBitmapDataRowInfo info, src_info;
+  int x0, x1;
+  if(!clip_blit_row(fb, src, src_rect, dest, row, &info, &src_info, &x0, &x1)) {
+    return;
+  }
+
+  int offset = src_rect.origin.x - dest.x;
+  int src_y = src_rect.origin.y + row;
+  const uint8_t *mask_data = mask ? gbitmap_get_data_row_info(mask, src_y).data : NULL;
+#if defined(PBL_COLOR)
+  if(!mask_data) {
+    memmove(&info.data[x0], &src_info.data[x0 + offset], x1 - x0 + 1);
+    return;
+  }
+
+  for(int x = x0; x <= x1; x++) {
+    int sx = x + offset;
+    if((mask_data[sx / 8] >> (sx % 8)) & 1) {
+      info.data[x] = src_info.data[sx];
+    }
+  }
+#elif defined(PBL_BW)
+  blit_bits(info.data, x0, x1, src_info.data, x0 + offset, mask_data);
+#endif
+}
+
+static bool is_format_compatible(GBitmap *fb, GBitmap *src) {
+  GBitmapFormat format = gbitmap_get_format(src);
+#if defined(PBL_COLOR)
+  // Offscreen bitmaps are rectangular even when the display is round
+  return format == GBitmapFormat8Bit || format == gbitmap_get_format(fb);
+#elif defined(PBL_BW)
+  return format == gbitmap_get_format(fb);
 #endif
+}
+
+static void blit(GBitmap *fb, GBitmap *src, GBitmap *mask, GRect src_rect, GPoint dest) {
+  if(!is_format_compatible(fb, src)) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "universal_fb: source bitmap must be in the framebuffer format");
+    return;
+  }
+  if(mask && gbitmap_get_format(mask) != GBitmapFormat1Bit) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "universal_fb: mask bitmap must be GBitmapFormat1Bit");
+    return;
+  }
+
+  if(fb == src && dest.y > src_rect.origin.y) {
+    // Copying down within one bitmap, so don't overwrite rows not yet copied
+    for(int row = src_rect.size.h - 1; row >= 0; row--) {
+      blit_row(fb, src, mask, src_rect, dest, row);
+    }
+  } else {
+    for(int row = 0; row < src_rect.size.h; row++) {
+      blit_row(fb, src, mask, src_rect, dest, row);
+    }
+  }
+}
+
+/**
+ * Read pixel x of a bitmap row in any format. Palettized formats are packed
+ * most significant bits first, unlike GBitmapFormat1Bit.
+ */
+static GColor read_pixel(const uint8_t *row, GBitmapFormat format, const GColor *palette, int x) {
+  switch(format) {
+    case GBitmapFormat1Bit:
+      return ((row[x / 8] >> (x % 8)) & 1) ? GColorWhite : GColorBlack;
+    case GBitmapFormat1BitPalette:
+      return palette[(row[x / 8] >> (7 - (x % 8))) & 0x1];
+    case GBitmapFormat2BitPalette:
+      return palette[(row[x / 4] >> ((3 - (x % 4)) * 2)) & 0x3];
+    case GBitmapFormat4BitPalette:
+      return palette[(row[x / 2] >> ((1 - (x % 2)) * 4)) & 0xF];
+    default:
+      return (GColor){ .argb = row[x] };
+  }
+}
+
+/**
+ * Mix two colors channel by channel, amount from 0 (all of a) to 3 (all of b)
+ */
+static GColor mix_colors(GColor a, GColor b, int amount) {
+  GColor result = GColorWhite;
+  result.r = ((a.r * (3 - amount)) + (b.r * amount) + 1) / 3;
+  result.g = ((a.g * (3 - amount)) + (b.g * amount) + 1) / 3;
+  result.b = ((a.b * (3 - amount)) + (b.b * amount) + 1) / 3;
+  return result;
+}
+
+/**
+ * Draw pixels x0 to x1 of a row from src starting at src_x, tinted and
+ * blended as described for universal_fb_blit_tinted()
+ */
+static void blit_tinted_row(GBitmapDataRowInfo info, int x0, int x1, const uint8_t *src, int src_x,
+                            GBitmapFormat format, const GColor *palette, GColor fg, GColor bg) {
+  bool tinted = !gcolor_equal(fg, GColorClear);
+  bool has_bg = !gcolor_equal(bg, GColorClear);
+  for(int x = x0; x <= x1; x++) {
+    GColor color = read_pixel(src, format, palette, src_x + (x - x0));
+    int alpha = color.a;
+    if(tinted) {
+      // Brightness picks how far from bg to fg, or how opaque fg is if no bg
+      int level = (color.r + color.g + color.b + 1) / 3;
+      if(has_bg) {
+        color = mix_colors(bg, fg, level);
+      } else {
+        color = fg;
+        alpha = (alpha * level) / 3;
+      }
+    }
+    if(alpha == 0) {
+      // Transparent
+      continue;
+    }
+
+#if defined(PBL_COLOR)
+    if(alpha < 3) {
+      color = mix_colors((GColor){ .argb = info.data[x] }, color, alpha);
+    }
+    info.data[x] = color.argb;
+#elif defined(PBL_BW)
+    if(alpha < 2) {
+      // Mostly transparent
+      continue;
+    }
+    bool white = (2 * color.r) + (5 * color.g) + color.b >= 12;
+    byte_set_bit(&info.data[x / 8], x % 8, white ? 1 : 0);
+#endif
+  }
+}
 
 /************************************ API *************************************/
 
 GColor universal_fb_get_pixel_color(GBitmapDataRowInfo info, GRect bounds, GPoint point) {
-  if(point.x > info.min_x && point.x < info.max_x
-  && point.y > bounds.origin.y && point.y < bounds.origin.y + bounds.size.h) {
+  if(point.x >= info.min_x && point.x <= info.max_x
+  && point.y >= bounds.origin.y && point.y < bounds.origin.y + bounds.size.h) {
 #if defined(PBL_COLOR)
     return (GColor){ .argb = info.data[point.x] };
 #elif defined(PBL_BW)
@@ -35,8 +253,8 @@ GColor universal_fb_get_pixel_color(GBitmapDataRowInfo info, GRect bounds, GPoin
 }
 
 void universal_fb_set_pixel_color(GBitmapDataRowInfo info, GRect bounds, GPoint point, GColor color) {
-  if(point.x > info.min_x && point.x < info.max_x
-  && point.y > bounds.origin.y && point.y < bounds.origin.y + bounds.size.h) {
+  if(point.x >= info.min_x && point.x <= info.max_x
+  && point.y >= bounds.origin.y && point.y < bounds.origin.y + bounds.size.h) {
 #if defined(PBL_COLOR)
     memset(&info.data[point.x], color.argb, 1);
 #elif defined(PBL_BW)
@@ -51,15 +269,115 @@ void universal_fb_set_pixel_color(GBitmapDataRowInfo info, GRect bounds, GPoint
 }
 
 void universal_fb_swap_colors(GBitmap *fb, GRect bounds, GColor c1, GColor c2) {
-  for(int y = bounds.origin.y; y < bounds.origin.y + bounds.size.h; y++) {
+  if(gcolor_equal(c1, c2)) {
+    return;
+  }
+
+#if defined(PBL_COLOR)
+  // What each pixel value becomes
+  uint8_t lut[256];
+  for(int i = 0; i < 256; i++) {
+    lut[i] = i;
+  }
+  lut[c1.argb] = c2.argb;
+  lut[c2.argb] = c1.argb;
+#elif defined(PBL_BW)
+  // What black and white pixels become, as whole bytes
+  GColor black = gcolor_equal(c1, GColorBlack) ? c2 : (gcolor_equal(c2, GColorBlack) ? c1 : GColorBlack);
+  GColor white = gcolor_equal(c1, GColorWhite) ? c2 : (gcolor_equal(c2, GColorWhite) ? c1 : GColorWhite);
+  uint8_t from_black = gcolor_equal(black, GColorWhite) ? 0xFF : 0x00;
+  uint8_t from_white = gcolor_equal(white, GColorWhite) ? 0xFF : 0x00;
+#endif
+
+  GRect fb_bounds = gbitmap_get_bounds(fb);
+  int y0 = (bounds.origin.y < fb_bounds.origin.y) ? fb_bounds.origin.y : bounds.origin.y;
+  int y1 = bounds.origin.y + bounds.size.h;
+  y1 = (y1 > fb_bounds.origin.y + fb_bounds.size.h) ? fb_bounds.origin.y + fb_bounds.size.h : y1;
+  for(int y = y0; y < y1; y++) {
+    // Only the part of the row that is actually visible
     GBitmapDataRowInfo info = gbitmap_get_data_row_info(fb, y);
-    for(int x = bounds.origin.x; x < bounds.origin.x + bounds.size.w; x++) {
-      GPoint p = GPoint(x, y);
-      if(gcolor_equal(universal_fb_get_pixel_color(info, bounds, p), c1)) {
-        universal_fb_set_pixel_color(info, bounds, p, c2);
-      } else if(gcolor_equal(universal_fb_get_pixel_color(info, bounds, p), c2)) {
-        universal_fb_set_pixel_color(info, bounds, p, c1);
-      }
+    int x0 = (bounds.origin.x < info.min_x) ? info.min_x : bounds.origin.x;
+    int x1 = bounds.origin.x + bounds.size.w - 1;
+    x1 = (x1 > info.max_x) ? info.max_x : x1;
+    if(x0 > x1) {
+      continue;
+    }
+
+#if defined(PBL_COLOR)
+    for(int x = x0; x <= x1; x++) {
+      info.data[x] = lut[info.data[x]];
+    }
+#elif defined(PBL_BW)
+    for(int b = x0 / 8; b <= x1 / 8; b++) {
+      int start = (b * 8 > x0) ? b * 8 : x0;
+      int end = ((b * 8) + 7 < x1) ? (b * 8) + 7 : x1;
+      uint8_t bits = get_byte_mask(start, end);
+      uint8_t byte = info.data[b];
+      uint8_t swapped = (from_black & ~byte) | (from_white & byte);
+      info.data[b] = (byte & ~bits) | (swapped & bits);
+    }
+#endif
+  }
+}
+
+void universal_fb_fill_span(GBitmapDataRowInfo info, int x0, int x1, GColor color) {
+  x0 = (x0 < info.min_x) ? info.min_x : x0;
+  x1 = (x1 > info.max_x) ? info.max_x : x1;
+  if(x0 > x1) {
+    return;
+  }
+
+#if defined(PBL_COLOR)
+  memset(&info.data[x0], color.argb, x1 - x0 + 1);
+#elif defined(PBL_BW)
+  uint8_t value = gcolor_equal(color, GColorWhite) ? 0xFF : 0x00;
+  int b0 = x0 / 8;
+  int b1 = x1 / 8;
+  if(b0 == b1) {
+    uint8_t bits = get_byte_mask(x0, x1);
+    info.data[b0] = (info.data[b0] & ~bits) | (value & bits);
+    return;
+  }
+
+  // Partial bytes at either end, whole bytes in between
+  uint8_t first = get_byte_mask(x0, 7);
+  uint8_t last = get_byte_mask(0, x1);
+  info.data[b0] = (info.data[b0] & ~first) | (value & first);
+  if(b1 - b0 > 1) {
+    memset(&info.data[b0 + 1], value, b1 - b0 - 1);
+  }
+  info.data[b1] = (info.data[b1] & ~last) | (value & last);
+#endif
+}
+
+void universal_fb_fill_rect(GBitmap *fb, GRect rect, GColor color) {
+  GRect bounds = gbitmap_get_bounds(fb);
+  int y0 = (rect.origin.y < bounds.origin.y) ? bounds.origin.y : rect.origin.y;
+  int y1 = rect.origin.y + rect.size.h;
+  y1 = (y1 > bounds.origin.y + bounds.size.h) ? bounds.origin.y + bounds.size.h : y1;
+  for(int y = y0; y < y1; y++) {
+    universal_fb_fill_span(gbitmap_get_data_row_info(fb, y),
+      rect.origin.x, rect.origin.x + rect.size.w - 1, color);
+  }
+}
+
+void universal_fb_copy_rect(GBitmap *fb, GBitmap *src, GRect src_rect, GPoint dest) {
+  blit(fb, src, NULL, src_rect, dest);
+}
+
+void universal_fb_blit_masked(GBitmap *fb, GBitmap *src, GBitmap *mask, GRect src_rect, GPoint dest) {
+  blit(fb, src, mask, src_rect, dest);
+}
+
+void universal_fb_blit_tinted(GBitmap *fb, GBitmap *src, GRect src_rect, GPoint dest, GColor fg, GColor bg) {
+  GBitmapFormat format = gbitmap_get_format(src);
+  const GColor *palette = gbitmap_get_palette(src);
+  for(int row = 0; row < src_rect.size.h; row++) {
+    GBitmapDataRowInfo info, src_info;
+    int x0, x1;
+    if(clip_blit_row(fb, src, src_rect, dest, row, &info, &src_info, &x0, &x1)) {
+      blit_tinted_row(info, x0, x1, src_info.data, x0 + src_rect.origin.x - dest.x,
+        format, palette, fg, bg);
     }
   }
 }
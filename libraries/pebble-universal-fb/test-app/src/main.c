@@ -1,6 +1,7 @@
 #include <pebble.h>
 
 #include <pebble-universal-fb/pebble-universal-fb.h>
+#include <pebble-universal-fb/pebble-universal-fb-post.h>
 
 static Window *s_window;
 static Layer *s_layer;
@@ -24,6 +25,60 @@ static void test_universal_fb(GBitmap *fb, GColor c1, GColor c2) {
   universal_fb_swap_colors(fb, grect_inset(bounds, GEdgeInsets(20)), c1, c2);
   test(gcolor_equal(universal_fb_get_pixel_color(info, bounds, test_point), c2), 
        "universal_fb_swap_colors");
+
+  // Test fill
+  universal_fb_fill_rect(fb, GRect(25, 25, 11, 11), c1);
+  test(gcolor_equal(universal_fb_get_pixel_color(info, bounds, test_point), c1), 
+       "universal_fb_fill_rect");
+
+  // Test copy
+  GBitmap *src = gbitmap_create_blank(GSize(16, 16), gbitmap_get_format(fb));
+  GBitmapDataRowInfo src_info = gbitmap_get_data_row_info(src, 3);
+  universal_fb_fill_span(src_info, 0, 15, c2);
+  universal_fb_copy_rect(fb, src, GRect(0, 3, 16, 1), GPoint(27, test_point.y));
+  test(gcolor_equal(universal_fb_get_pixel_color(info, bounds, test_point), c2), 
+       "universal_fb_fill_span/copy_rect");
+  gbitmap_destroy(src);
+
+  // Test tint
+  GBitmap *mask = gbitmap_create_blank(GSize(16, 16), GBitmapFormat1Bit);
+  memset(gbitmap_get_data(mask), 0xFF, gbitmap_get_bytes_per_row(mask) * 16);
+  universal_fb_blit_tinted(fb, mask, gbitmap_get_bounds(mask), GPoint(25, 25), c1, GColorClear);
+  test(gcolor_equal(universal_fb_get_pixel_color(info, bounds, test_point), c1), 
+       "universal_fb_blit_tinted");
+  gbitmap_destroy(mask);
+}
+
+static void test_post_process(GBitmap *fb, GColor c1, GColor c2) {
+  // A square of c1 on c2, in the middle so it is visible on round displays
+  GRect bounds = gbitmap_get_bounds(fb);
+  GPoint center = grect_center_point(&bounds);
+  universal_fb_fill_rect(fb, bounds, c2);
+  universal_fb_fill_rect(fb, GRect(center.x - 5, center.y - 5, 10, 10), c1);
+
+  // Outline it, then swap c1 and c2, in one pass
+  GColor outline = PBL_IF_COLOR_ELSE(GColorRed, c1);
+  const UniversalFBEffect effects[] = {
+    { .type = UniversalFBEffectOutline, .match = c1, .color = outline },
+    { .type = UniversalFBEffectInvert, .match = c1, .color = c2 }
+  };
+  universal_fb_post_process(fb, effects, ARRAY_LENGTH(effects));
+
+  GBitmapDataRowInfo info = gbitmap_get_data_row_info(fb, center.y);
+  test(gcolor_equal(universal_fb_get_pixel_color(info, bounds, center), c2),
+       "universal_fb_post_process inside");
+  GColor expected = PBL_IF_COLOR_ELSE(outline, c2);
+  test(gcolor_equal(universal_fb_get_pixel_color(info, bounds, GPoint(center.x - 6, center.y)), expected),
+       "universal_fb_post_process outline");
+  test(gcolor_equal(universal_fb_get_pixel_color(info, bounds, GPoint(center.x - 7, center.y)), c1),
+       "universal_fb_post_process outside");
+
+  // The row above the square is outlined too, but not its corner
+  info = gbitmap_get_data_row_info(fb, center.y - 6);
+  test(gcolor_equal(universal_fb_get_pixel_color(info, bounds, GPoint(center.x, center.y - 6)), expected),
+       "universal_fb_post_process outline above");
+  test(gcolor_equal(universal_fb_get_pixel_color(info, bounds, GPoint(center.x - 6, center.y - 6)), c1),
+       "universal_fb_post_process corner");
 }
 
 static void update_proc(Layer *layer, GContext *ctx) {
@@ -32,6 +87,7 @@ static void update_proc(Layer *layer, GContext *ctx) {
 
   GBitmap *fb = graphics_capture_frame_buffer(ctx);
   test_universal_fb(fb, c1, c2);
+  test_post_process(fb, c1, c2);
   graphics_release_frame_buffer(ctx, fb);
 }
 
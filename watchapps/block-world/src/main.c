@@ -11,7 +11,14 @@ int g_angle = 0;
 static Window *s_main_window;
 static TextLayer *s_status_layer;
 
-static Block *s_block_array[GRID_WIDTH * GRID_HEIGHT * GRID_DEPTH];
+static GColor s_world[GRID_WIDTH * GRID_HEIGHT * GRID_DEPTH];
+static IsometricVoxelGrid s_world_grid = {
+  .voxels = s_world,
+  .width = GRID_WIDTH,
+  .height = GRID_HEIGHT,
+  .depth = GRID_DEPTH,
+  .voxel_size = BLOCK_SIZE
+};
 static Cloud *s_cloud_array[MAX_CLOUDS];
 
 static Vec3 s_cursor;
@@ -20,12 +27,6 @@ static int s_block_choice = BLOCK_GRASS;
 
 static void update_status_text();
 
-#ifdef BENCHMARK
-static int get_world_size() {
-  return sizeof(s_block_array) * block_get_struct_size();
-}
-#endif
-
 static int vec2i(Vec3 vec) {
   if(vec.x >= 0 
   && vec.x < GRID_WIDTH 
@@ -34,7 +35,7 @@ static int vec2i(Vec3 vec) {
   && vec.z >= 0
   && vec.z < GRID_DEPTH
   ) {
-    return (vec.z * (GRID_WIDTH * GRID_HEIGHT)) + (vec.y * GRID_HEIGHT) + vec.x;
+    return (vec.z * (GRID_WIDTH * GRID_HEIGHT)) + (vec.y * GRID_WIDTH) + vec.x;
   } else {
     return -1;
   }
@@ -68,14 +69,12 @@ static void render(GContext *ctx) {
 
   isometric_begin(ctx);
 
-  // Tiles
-  for(int z = 0; z < GRID_DEPTH; z++) {
-    for(int y = 0; y < GRID_HEIGHT; y++) {
-      for(int x = 0; x < GRID_WIDTH; x++) {
-        block_render(s_block_array[vec2i(Vec3(x, y, z))]);
-      }
-    }
-  }
+  // Tiles, skipping those hidden by others
+#ifdef OUTLINES
+  isometric_draw_voxel_grid(&s_world_grid, Vec3(0, 0, 0), GColorDarkGray);
+#else
+  isometric_draw_voxel_grid(&s_world_grid, Vec3(0, 0, 0), GColorClear);
+#endif
 
   for(int i = 0; i < MAX_CLOUDS; i++) {
     cloud_render(s_cloud_array[i]);
@@ -133,22 +132,22 @@ static void click(int button_id, bool long_click) {
     case BUTTON_ID_SELECT:
       switch(s_block_choice) {
         case BLOCK_GRASS:
-          block_set_color(s_block_array[vec2i(s_cursor)], COLOR_GRASS);
+          s_world[vec2i(s_cursor)] = COLOR_GRASS;
           break;
         case BLOCK_SAND:
-          block_set_color(s_block_array[vec2i(s_cursor)], COLOR_SAND);
+          s_world[vec2i(s_cursor)] = COLOR_SAND;
           break;
         case BLOCK_WATER:   
-          block_set_color(s_block_array[vec2i(s_cursor)], COLOR_WATER);
+          s_world[vec2i(s_cursor)] = COLOR_WATER;
           break;
         case BLOCK_RED:
-          block_set_color(s_block_array[vec2i(s_cursor)], COLOR_RED);
+          s_world[vec2i(s_cursor)] = COLOR_RED;
           break;
         case BLOCK_STONE:
-          block_set_color(s_block_array[vec2i(s_cursor)], COLOR_STONE);
+          s_world[vec2i(s_cursor)] = COLOR_STONE;
           break;
         case BLOCK_DELETE:
-          block_set_color(s_block_array[vec2i(s_cursor)], COLOR_INVISIBLE);
+          s_world[vec2i(s_cursor)] = COLOR_INVISIBLE;
           break;
       }
       
@@ -181,7 +180,7 @@ static bool is_near_color(GPoint origin, int z, GColor query) {
       // Check only on this level
       int checked_point = vec2i(Vec3(x, y, z));
       if(checked_point > 0) {
-        if(block_get_color(s_block_array[checked_point]).argb == query.argb) {
+        if(s_world[checked_point].argb == query.argb) {
           return true;
         }
       }
@@ -198,7 +197,7 @@ static bool near_this_many_of_color(GPoint origin, int z, GColor query, int num)
       // Check only on this level
       int checked_point = vec2i(Vec3(x, y, z));
       if(checked_point > 0) {
-        if(block_get_color(s_block_array[checked_point]).argb == query.argb) {
+        if(s_world[checked_point].argb == query.argb) {
           result++;
         }
       }
@@ -218,7 +217,7 @@ static void generate_world() {
   // Bottom level grass
   for(int y = 0; y < GRID_HEIGHT; y++) {
     for(int x = 0; x < GRID_WIDTH; x++) {
-      block_set_color(s_block_array[vec2i(Vec3(x, y, 0))], COLOR_GRASS);
+      s_world[vec2i(Vec3(x, y, 0))] = COLOR_GRASS;
     }
   }
 
@@ -226,7 +225,7 @@ static void generate_world() {
   for(int y = 0; y < GRID_HEIGHT; y++) {
     for(int x = 0; x < GRID_WIDTH; x++) {
       if(rand() % 100 > SAND_SEED_BIAS) {
-        block_set_color(s_block_array[vec2i(Vec3(x, y, 0))], COLOR_SAND);
+        s_world[vec2i(Vec3(x, y, 0))] = COLOR_SAND;
       }
     }
   }
@@ -236,14 +235,14 @@ static void generate_world() {
     for(int x = 0; x < GRID_WIDTH; x++) {
       if(rand() % 100 > SAND_CLUMP_BIAS
       && is_near_color(GPoint(x, y), 0, COLOR_SAND)) {
-        block_set_color(s_block_array[vec2i(Vec3(x, y, 0))], COLOR_SAND);
+        s_world[vec2i(Vec3(x, y, 0))] = COLOR_SAND;
       }
     }
   }
   for(int y = 0; y < GRID_HEIGHT; y++) {
     for(int x = 0; x < GRID_WIDTH; x++) {
       if(near_this_many_of_color(GPoint(x, y), 0, COLOR_SAND, SAND_NEIGHBOURS)) {
-        block_set_color(s_block_array[vec2i(Vec3(x, y, 0))], COLOR_SAND);
+        s_world[vec2i(Vec3(x, y, 0))] = COLOR_SAND;
       }
     }
   }
@@ -253,7 +252,7 @@ static void generate_world() {
   for(int y = 0; y < GRID_HEIGHT; y++) {
     for(int x = 0; x < GRID_WIDTH; x++) {
       if(near_this_many_of_color(GPoint(x, y), 0, COLOR_SAND, WATER_NEIGHBOURS)) {
-        block_set_color(s_block_array[vec2i(Vec3(x, y, 0))], COLOR_WATER);
+        s_world[vec2i(Vec3(x, y, 0))] = COLOR_WATER;
       }
     }
   }
@@ -263,7 +262,7 @@ static void generate_world() {
     for(int x = 0; x < GRID_WIDTH; x++) {
       if(rand() % 100 > WATER_CLUMP_BIAS
       && is_near_color(GPoint(x, y), 0, COLOR_WATER)) {
-        block_set_color(s_block_array[vec2i(Vec3(x, y, 0))], COLOR_WATER);
+        s_world[vec2i(Vec3(x, y, 0))] = COLOR_WATER;
       }
     }
   }
@@ -273,31 +272,31 @@ static void generate_world() {
   int y = 6;
   for(y = 6; y < 10; y++) {
     for(int z = 0; z < 6; z++) {
-      block_set_color(s_block_array[vec2i(Vec3(x, y, z))], COLOR_STONE);
+      s_world[vec2i(Vec3(x, y, z))] = COLOR_STONE;
     }
   }
   y = 11;
   for(x = 2; x < 6; x++) {
     for(int z = 0; z < 6; z++) {
-      block_set_color(s_block_array[vec2i(Vec3(x, y, z))], COLOR_STONE);
+      s_world[vec2i(Vec3(x, y, z))] = COLOR_STONE;
     }
   }
   y = 6;
   for(x = 2; x < 6; x++) {
     for(int z = 0; z < 6; z++) {
-      block_set_color(s_block_array[vec2i(Vec3(x, y, z))], COLOR_STONE);
+      s_world[vec2i(Vec3(x, y, z))] = COLOR_STONE;
     }
   }
   x = 6;
   for(y = 6; y < 10; y++) {
     for(int z = 0; z < 6; z++) {
-      block_set_color(s_block_array[vec2i(Vec3(x, y, z))], COLOR_STONE);
+      s_world[vec2i(Vec3(x, y, z))] = COLOR_STONE;
     }
   }
   int z = 6;
   for(y = 6; y < 10; y++) {
     for(x = 2; x < 7; x++) {
-      block_set_color(s_block_array[vec2i(Vec3(x, y, z))], COLOR_STONE);
+      s_world[vec2i(Vec3(x, y, z))] = COLOR_STONE;
     }
   }
 
@@ -339,16 +338,8 @@ static void update_status_text() {
 
 void pge_init() {
   // Allocate
-  for(int z = 0; z < GRID_DEPTH; z++) {
-    for(int y = 0; y < GRID_HEIGHT; y++) {
-      for(int x = 0; x < GRID_WIDTH; x++) {
-        s_block_array[vec2i(Vec3(x, y, z))] = block_create(
-          Vec3(x * BLOCK_SIZE, y * BLOCK_SIZE, z * BLOCK_SIZE),
-          GSize(BLOCK_SIZE, BLOCK_SIZE),
-          COLOR_INVISIBLE
-        );
-      }
-    }
+  for(int i = 0; i < GRID_WIDTH * GRID_HEIGHT * GRID_DEPTH; i++) {
+    s_world[i] = COLOR_INVISIBLE;
   }
   for(int i = 0; i < MAX_CLOUDS; i++) {
     s_cloud_array[i] = cloud_create(
@@ -383,7 +374,7 @@ void pge_init() {
     "Heap free: %dB after creating %d blocks (Size: %dB)",
     (int)heap_bytes_free(),
     (GRID_WIDTH * GRID_HEIGHT * GRID_DEPTH),
-    get_world_size()
+    (int)sizeof(s_world)
   );
 #endif
 }
@@ -394,13 +385,6 @@ void pge_deinit() {
   text_layer_destroy(s_status_layer);
 
   // Deallocate
-  for(int z = 0; z < GRID_DEPTH; z++) {
-    for(int y = 0; y < GRID_HEIGHT; y++) {
-      for(int x = 0; x < GRID_WIDTH; x++) {
-        block_destroy(s_block_array[vec2i(Vec3(x, y, z))]);
-      }
-    }
-  }
   for(int i = 0; i < MAX_CLOUDS; i++) {
     cloud_destroy(s_cloud_array[i]);
   }
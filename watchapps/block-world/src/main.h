@@ -64,7 +64,7 @@ typedef struct {
 #define COLOR_CLOUD GColorWhite
 #define COLOR_RED GColorOrange
 #define COLOR_STONE GColorLightGray
-#define COLOR_INVISIBLE GColorBlack
+#define COLOR_INVISIBLE GColorClear
 
 // UI
 #define MODE_X 0
@@ -6,8 +6,9 @@ static TextLayer *s_score_layer;
 
 // Game
 static Ship *s_player = NULL;
-static Shot *shot_arr[MAX_OBJECTS];
-static Rock *rock_arr[MAX_OBJECTS];
+static PGEPool *s_shot_pool, *s_rock_pool;
+static PGESpriteAtlas *s_shot_atlas, *s_rock_atlas;
+static PGECollisionWorld *s_world;
 
 // State
 static char s_score_buffer[32];
@@ -27,30 +28,40 @@ static void fire() {
   // Adjust
   pos.x += bounds.size.w / 2;
 
-  // Find slot
-  for(int i = 0; i < MAX_OBJECTS; i++) {
-    if(!shot_arr[i]) {
-      shot_arr[i] = shot_create(pos);
-      return;
-    }
+  // Take a free slot, if any
+  Shot *shot = pge_pool_acquire(s_shot_pool);
+  if(shot) {
+    shot_init(shot, pos, s_shot_atlas);
+    shot->body = pge_collision_world_add(s_world, &shot->sprite, GROUP_SHOT, shot);
   }
 }
 
+static void despawn_shot(Shot *shot) {
+  pge_collision_world_remove(s_world, shot->body);
+  shot_deinit(shot);
+  pge_pool_release(s_shot_pool, shot);
+}
+
 static void spawn_rock() {
   GPoint pos = GPoint(rand() % 144, -20);
   if(pos.x > 144 - 30) {
     pos.x = 144 - 30;
   }
 
-  // Find slot
-  for(int i = 0; i < MAX_OBJECTS; i++) {
-    if(!rock_arr[i]) {
-      rock_arr[i] = rock_create(pos);
-      return;
-    }
+  // Take a free slot, if any
+  Rock *rock = pge_pool_acquire(s_rock_pool);
+  if(rock) {
+    rock_init(rock, pos, s_rock_atlas);
+    rock->body = pge_collision_world_add(s_world, &rock->sprite, GROUP_ROCK, rock);
   }
 }
 
+static void despawn_rock(Rock *rock) {
+  pge_collision_world_remove(s_world, rock->body);
+  rock_deinit(rock);
+  pge_pool_release(s_rock_pool, rock);
+}
+
 static void spawn_handler(void *context) {
   spawn_rock();
 
@@ -58,6 +69,27 @@ static void spawn_handler(void *context) {
   app_timer_register(rand() % MAX_SPAWN_INTERVAL, spawn_handler, NULL);
 }
 
+static void shot_hit_rock(void *shot, void *rock) {
+  //Boom!
+  despawn_rock(rock);
+  despawn_shot(shot);
+
+  // Award points
+  s_score++;
+  update_status_text();
+}
+
+static void ship_hit_rock(void *ship, void *rock) {
+  // Lose a life
+  s_lives--;
+  update_status_text();
+
+  vibes_long_pulse();
+
+  // Destroy rock
+  despawn_rock(rock);
+}
+
 /******************************** Engine callbacks ****************************/
 
 static void logic() {
@@ -71,67 +103,32 @@ static void logic() {
     ship_move(s_player, SHIP_MOVE_SPEED);
   }
 
-  // Move shots
-  for(int i = 0; i < MAX_OBJECTS; i++) {
-    if(shot_arr[i]) {
-      shot_logic(shot_arr[i]);
+  // Move shots - backwards, as despawning moves the last one into its place
+  for(int i = pge_pool_get_count(s_shot_pool) - 1; i >= 0; i--) {
+    Shot *shot = pge_pool_get(s_shot_pool, i);
+    shot_logic(shot);
 
-      // Out of bounds?
-      if(shot_get_position(shot_arr[i]).y < 0) {
-        shot_destroy(shot_arr[i]);
-        shot_arr[i] = NULL;
-      }
+    // Out of bounds?
+    if(shot_get_position(shot).y < 0) {
+      despawn_shot(shot);
     }
   }
 
   // Move rocks
-  for(int i = 0; i < MAX_OBJECTS; i++) {
-    if(rock_arr[i]) {
-      rock_logic(rock_arr[i]);
-
-      // Out of bounds of bottom of screen?
-      if(rock_get_position(rock_arr[i]).y > 168) {
-        rock_destroy(rock_arr[i]);
-        rock_arr[i] = NULL;
-      }
-    }
-  }
+  for(int i = pge_pool_get_count(s_rock_pool) - 1; i >= 0; i--) {
+    Rock *rock = pge_pool_get(s_rock_pool, i);
+    rock_logic(rock);
 
-  // Do shot collision with rocks
-  for(int s = 0; s < MAX_OBJECTS; s++) {
-    for(int r = 0; r < MAX_OBJECTS; r++) {
-      if(rock_arr[r] && shot_arr[s]) {
-        if(pge_check_collision(rock_arr[r]->sprite, shot_arr[s]->sprite)) {
-          //Boom!
-          rock_destroy(rock_arr[r]);
-          shot_destroy(shot_arr[s]);
-          rock_arr[r] = NULL;
-          shot_arr[s] = NULL;
-
-          // Award points
-          s_score++;
-          update_status_text();
-        }
-      }
+    // Out of bounds of bottom of screen?
+    if(rock_get_position(rock).y > 168) {
+      despawn_rock(rock);
     }
   }
 
-  // Do rock collision with player
-  for(int i = 0; i < MAX_OBJECTS; i++) {
-    if(rock_arr[i]) {
-      if(pge_check_collision(s_player->sprite, rock_arr[i]->sprite)) {
-        // Lose a life
-        s_lives--;
-        update_status_text();
-
-        vibes_long_pulse();
-
-        // Destroy rock
-        rock_destroy(rock_arr[i]);
-        rock_arr[i] = NULL;
-      }
-    }
-  }
+  // Do shot collision with rocks, then rock collision with player
+  pge_collision_world_update(s_world);
+  pge_collision_world_find_pairs(s_world, GROUP_SHOT, GROUP_ROCK, shot_hit_rock);
+  pge_collision_world_find_pairs(s_world, GROUP_SHIP, GROUP_ROCK, ship_hit_rock);
 
   if(s_lives == 0) {
     window_stack_pop_all(true);
@@ -144,17 +141,13 @@ static void draw(GContext *ctx) {
   ship_draw(s_player, ctx);
 
   // Draw any active shots
-  for(int i = 0; i < MAX_OBJECTS; i++) {
-    if(shot_arr[i]) {
-      shot_draw(shot_arr[i], ctx);
-    }
+  for(int i = 0; i < pge_pool_get_count(s_shot_pool); i++) {
+    shot_draw(pge_pool_get(s_shot_pool, i), ctx);
   }
 
   // Draw any active rocks
-  for(int i = 0; i < MAX_OBJECTS; i++) {
-    if(rock_arr[i]) {
-      rock_draw(rock_arr[i], ctx);
-    }
+  for(int i = 0; i < pge_pool_get_count(s_rock_pool); i++) {
+    rock_draw(pge_pool_get(s_rock_pool, i), ctx);
   }
 }
 
@@ -172,6 +165,7 @@ static void click(int button_id, bool long_click) {
 static void splash_done_handler() {
   // Create player's Ship
   s_player = ship_create(GPoint(60, 130));
+  pge_collision_world_add(s_world, s_player->sprite, GROUP_SHIP, s_player);
 
   // Begin game loop
   pge_begin(logic, draw, click);
@@ -195,6 +189,13 @@ static void splash_done_handler() {
 void pge_init() {
   srand(time(NULL));
 
+  // Allocate everything up front, so the game loop never does
+  s_shot_pool = pge_pool_create(sizeof(Shot), MAX_OBJECTS);
+  s_rock_pool = pge_pool_create(sizeof(Rock), MAX_OBJECTS);
+  s_shot_atlas = pge_sprite_atlas_create(RESOURCE_ID_SHOT, GSize(0, 0));
+  s_rock_atlas = pge_sprite_atlas_create(RESOURCE_ID_ROCK, GSize(0, 0));
+  s_world = pge_collision_world_create(GRect(0, 0, 144, 168), ROCK_SIZE, (2 * MAX_OBJECTS) + 1);
+
   pge_splash_show(splash_done_handler);
 }
 
@@ -203,14 +204,17 @@ void pge_deinit() {
   text_layer_destroy(s_score_layer);
 
   //Free Shots and Rocks
-  for(int i = 0; i < MAX_OBJECTS; i++) {
-    if(shot_arr[i]) {
-      shot_destroy(shot_arr[i]);
-    }
-    if(rock_arr[i]) {
-      rock_destroy(rock_arr[i]);
-    }
+  for(int i = 0; i < pge_pool_get_count(s_shot_pool); i++) {
+    shot_deinit(pge_pool_get(s_shot_pool, i));
+  }
+  for(int i = 0; i < pge_pool_get_count(s_rock_pool); i++) {
+    rock_deinit(pge_pool_get(s_rock_pool, i));
   }
+  pge_pool_destroy(s_shot_pool);
+  pge_pool_destroy(s_rock_pool);
+  pge_sprite_atlas_destroy(s_shot_atlas);
+  pge_sprite_atlas_destroy(s_rock_atlas);
+  pge_collision_world_destroy(s_world);
 
   // Destroy the player's Ship
   if(s_player) {
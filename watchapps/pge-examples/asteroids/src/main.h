@@ -4,6 +4,7 @@
 
 #include <pebble-pge/pge.h>
 #include <pebble-pge/pge_collision.h>
+#include <pebble-pge/pge_pool.h>
 #include <pebble-pge/pge_sprite.h>
 #include <pebble-pge/pge_splash.h>
 
@@ -12,4 +13,10 @@
 #include "sprites/rock.h"
 
 #define MAX_OBJECTS 10
-#define MAX_SPAWN_INTERVAL 3000
\ No newline at end of file
+#define MAX_SPAWN_INTERVAL 3000
+#define ROCK_SIZE 32
+
+// Collision groups
+#define GROUP_SHIP 0
+#define GROUP_SHOT 1
+#define GROUP_ROCK 2
\ No newline at end of file
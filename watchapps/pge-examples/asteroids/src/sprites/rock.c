@@ -1,18 +1,15 @@
 #include "rock.h"
 
-Rock* rock_create(GPoint pos) {
-  Rock *this = malloc(sizeof(Rock));
-  this->sprite = pge_sprite_create(pos, RESOURCE_ID_ROCK);
-  return this;
+void rock_init(Rock *this, GPoint pos, PGESpriteAtlas *atlas) {
+  pge_sprite_init_with_atlas(&this->sprite, pos, atlas, 0);
 }
 
-void rock_destroy(Rock* this) {
-  pge_sprite_destroy(this->sprite);
-  free(this);
+void rock_deinit(Rock *this) {
+  pge_sprite_deinit(&this->sprite);
 }
 
 void rock_draw(Rock *this, GContext *ctx) {
-  pge_sprite_draw(this->sprite, ctx);
+  pge_sprite_draw(&this->sprite, ctx);
 }
 
 void rock_logic(Rock *this) {
@@ -21,15 +18,15 @@ void rock_logic(Rock *this) {
 }
 
 void rock_move(Rock *this, int dy) {
-  GPoint pos = pge_sprite_get_position(this->sprite);
+  GPoint pos = pge_sprite_get_position(&this->sprite);
   pos.y += dy;
-  pge_sprite_set_position(this->sprite, pos);
+  pge_sprite_set_position(&this->sprite, pos);
 }
 
 GPoint rock_get_position(Rock *this) {
-  return pge_sprite_get_position(this->sprite);
+  return pge_sprite_get_position(&this->sprite);
 }
 
 GRect rock_get_bounds(Rock *this) {
-  return pge_sprite_get_bounds(this->sprite);
+  return pge_sprite_get_bounds(&this->sprite);
 }
\ No newline at end of file
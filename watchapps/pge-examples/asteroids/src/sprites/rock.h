@@ -3,12 +3,13 @@
 #include "../main.h"
 
 typedef struct {
-  PGESprite *sprite;
+  PGESprite sprite;
+  int body;
 } Rock;
 
-Rock* rock_create(GPoint pos);
+void rock_init(Rock *this, GPoint pos, PGESpriteAtlas *atlas);
 
-void rock_destroy(Rock* this);
+void rock_deinit(Rock *this);
 
 void rock_draw(Rock *this, GContext *ctx);
 
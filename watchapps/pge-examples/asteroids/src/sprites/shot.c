@@ -1,18 +1,15 @@
 #include "shot.h"
 
-Shot* shot_create(GPoint pos) {
-  Shot *this = malloc(sizeof(Shot));
-  this->sprite = pge_sprite_create(pos, RESOURCE_ID_SHOT);
-  return this;
+void shot_init(Shot *this, GPoint pos, PGESpriteAtlas *atlas) {
+  pge_sprite_init_with_atlas(&this->sprite, pos, atlas, 0);
 }
 
-void shot_destroy(Shot* this) {
-  pge_sprite_destroy(this->sprite);
-  free(this);
+void shot_deinit(Shot *this) {
+  pge_sprite_deinit(&this->sprite);
 }
 
 void shot_draw(Shot *this, GContext *ctx) {
-  pge_sprite_draw(this->sprite, ctx);
+  pge_sprite_draw(&this->sprite, ctx);
 }
 
 void shot_logic(Shot *this) {
@@ -21,15 +18,15 @@ void shot_logic(Shot *this) {
 }
 
 void shot_move(Shot *this, int dy) {
-  GPoint pos = pge_sprite_get_position(this->sprite);
+  GPoint pos = pge_sprite_get_position(&this->sprite);
   pos.y += dy;
-  pge_sprite_set_position(this->sprite, pos);
+  pge_sprite_set_position(&this->sprite, pos);
 }
 
 GPoint shot_get_position(Shot *this) {
-  return pge_sprite_get_position(this->sprite);
+  return pge_sprite_get_position(&this->sprite);
 }
 
 GRect shot_get_bounds(Shot *this) {
-  return pge_sprite_get_bounds(this->sprite);
+  return pge_sprite_get_bounds(&this->sprite);
 }
\ No newline at end of file
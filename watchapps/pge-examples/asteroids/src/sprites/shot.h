@@ -3,12 +3,13 @@
 #include "../main.h"
 
 typedef struct {
-  PGESprite *sprite;
+  PGESprite sprite;
+  int body;
 } Shot;
 
-Shot* shot_create(GPoint pos);
+void shot_init(Shot *this, GPoint pos, PGESpriteAtlas *atlas);
 
-void shot_destroy(Shot* this);
+void shot_deinit(Shot *this);
 
 void shot_draw(Shot *this, GContext *ctx);
 
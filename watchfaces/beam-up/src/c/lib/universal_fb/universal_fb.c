@@ -14,13 +14,20 @@ static bool byte_get_bit(uint8_t *byte, uint8_t bit) {
 static void byte_set_bit(uint8_t *byte, uint8_t bit, uint8_t value) {
   *byte ^= (-value ^ *byte) & (1 << bit);
 }
+
+/**
+ * Bits of the byte holding pixels x0 to x1 inclusive, which must share a byte
+ */
+static uint8_t get_byte_mask(int x0, int x1) {
+  return (uint8_t)((0xFF << (x0 % 8)) & (0xFF >> (7 - (x1 % 8))));
+}
 #endif
 
 /************************************ API *************************************/
 
 GColor universal_fb_get_pixel_color(GBitmapDataRowInfo info, GRect bounds, GPoint point) {
-  if(point.x > info.min_x && point.x < info.max_x
-  && point.y > bounds.origin.y && point.y < bounds.origin.y + bounds.size.h) {
+  if(point.x >= info.min_x && point.x <= info.max_x
+  && point.y >= bounds.origin.y && point.y < bounds.origin.y + bounds.size.h) {
 #if defined(PBL_COLOR)
     return (GColor){ .argb = info.data[point.x] };
 #elif defined(PBL_BW)
@@ -35,8 +42,8 @@ GColor universal_fb_get_pixel_color(GBitmapDataRowInfo info, GRect bounds, GPoin
 }
 
 void universal_fb_set_pixel_color(GBitmapDataRowInfo info, GRect bounds, GPoint point, GColor color) {
-  if(point.x > info.min_x && point.x < info.max_x
-  && point.y > bounds.origin.y && point.y < bounds.origin.y + bounds.size.h) {
+  if(point.x >= info.min_x && point.x <= info.max_x
+  && point.y >= bounds.origin.y && point.y < bounds.origin.y + bounds.size.h) {
 #if defined(PBL_COLOR)
     memset(&info.data[point.x], color.argb, 1);
 #elif defined(PBL_BW)
@@ -51,15 +58,53 @@ void universal_fb_set_pixel_color(GBitmapDataRowInfo info, GRect bounds, GPoint
 }
 
 void universal_fb_swap_colors(GBitmap *fb, GRect bounds, GColor c1, GColor c2) {
-  for(int y = bounds.origin.y; y < bounds.origin.y + bounds.size.h; y++) {
+  if(gcolor_equal(c1, c2)) {
+    return;
+  }
+
+#if defined(PBL_COLOR)
+  // What each pixel value becomes
+  uint8_t lut[256];
+  for(int i = 0; i < 256; i++) {
+    lut[i] = i;
+  }
+  lut[c1.argb] = c2.argb;
+  lut[c2.argb] = c1.argb;
+#elif defined(PBL_BW)
+  // What black and white pixels become, as whole bytes
+  GColor black = gcolor_equal(c1, GColorBlack) ? c2 : (gcolor_equal(c2, GColorBlack) ? c1 : GColorBlack);
+  GColor white = gcolor_equal(c1, GColorWhite) ? c2 : (gcolor_equal(c2, GColorWhite) ? c1 : GColorWhite);
+  uint8_t from_black = gcolor_equal(black, GColorWhite) ? 0xFF : 0x00;
+  uint8_t from_white = gcolor_equal(white, GColorWhite) ? 0xFF : 0x00;
+#endif
+
+  GRect fb_bounds = gbitmap_get_bounds(fb);
+  int y0 = (bounds.origin.y < fb_bounds.origin.y) ? fb_bounds.origin.y : bounds.origin.y;
+  int y1 = bounds.origin.y + bounds.size.h;
+  y1 = (y1 > fb_bounds.origin.y + fb_bounds.size.h) ? fb_bounds.origin.y + fb_bounds.size.h : y1;
+  for(int y = y0; y < y1; y++) {
+    // Only the part of the row that is actually visible
     GBitmapDataRowInfo info = gbitmap_get_data_row_info(fb, y);
-    for(int x = bounds.origin.x; x < bounds.origin.x + bounds.size.w; x++) {
-      GPoint p = GPoint(x, y);
-      if(gcolor_equal(universal_fb_get_pixel_color(info, bounds, p), c1)) {
-        universal_fb_set_pixel_color(info, bounds, p, c2);
-      } else if(gcolor_equal(universal_fb_get_pixel_color(info, bounds, p), c2)) {
-        universal_fb_set_pixel_color(info, bounds, p, c1);
-      }
+    int x0 = (bounds.origin.x < info.min_x) ? info.min_x : bounds.origin.x;
+    int x1 = bounds.origin.x + bounds.size.w - 1;
+    x1 = (x1 > info.max_x) ? info.max_x : x1;
+    if(x0 > x1) {
+      continue;
     }
+
+#if defined(PBL_COLOR)
+    for(int x = x0; x <= x1; x++) {
+      info.data[x] = lut[info.data[x]];
+    }
+#elif defined(PBL_BW)
+    for(int b = x0 / 8; b <= x1 / 8; b++) {
+      int start = (b * 8 > x0) ? b * 8 : x0;
+      int end = ((b * 8) + 7 < x1) ? (b * 8) + 7 : x1;
+      uint8_t bits = get_byte_mask(start, end);
+      uint8_t byte = info.data[b];
+      uint8_t swapped = (from_black & ~byte) | (from_white & byte);
+      info.data[b] = (byte & ~bits) | (swapped & bits);
+    }
+#endif
   }
 }
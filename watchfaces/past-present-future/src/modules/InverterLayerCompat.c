@@ -1,38 +1,28 @@
 #ifdef PBL_PLATFORM_BASALT
 #include "InverterLayerCompat.h"
 
-static GColor s_fg_color, s_bg_color;
+// What each pixel's color becomes, shared like the colors themselves
+static uint8_t s_lut[256];
+static bool s_colors_set = false;
 
-static GColor get_pixel(uint8_t *fb_data, GSize fb_size, GPoint pixel) {
-  if(pixel.x >= 0 && pixel.x < 144 && pixel.y >= 0 && pixel.y < 168) {
-    return (GColor) { .argb = fb_data[(pixel.y * fb_size.w) + pixel.x] };
-  } else {
-    return GColorRed;
+static void layer_update_proc(Layer *layer, GContext *ctx) {
+  if(!s_colors_set) {
+    // Nothing to swap yet
+    return;
   }
-}
 
-static void set_pixel(uint8_t *fb_data, GSize fb_size, GPoint pixel, GColor color) {
-  if(pixel.x >= 0 && pixel.x < 144 && pixel.y >= 0 && pixel.y < 168) {
-    memset(&fb_data[(pixel.y * fb_size.w) + pixel.x], (uint8_t)color.argb, 1);
-  }
-}
-
-static void layer_update_proc(Layer *layer, GContext *ctx) {
   // Use framebuffer to emulate inverstion
   GBitmap *fb = graphics_capture_frame_buffer(ctx);
-  GSize size = gbitmap_get_bounds(fb).size;
+  GRect bounds = gbitmap_get_bounds(fb);
   GRect frame = layer_get_frame(layer);
   uint8_t *fb_data = gbitmap_get_data(fb);
 
+  // Only where the frame is on screen
+  grect_clip(&frame, &bounds);
   for(int y = frame.origin.y; y < frame.origin.y + frame.size.h; y++) {
-    for(int x = frame.origin.x; x < frame.origin.x + frame.size.w; x++) {
-      if(gcolor_equal(get_pixel(fb_data, size, GPoint(x, y)), s_fg_color)) {
-        // Invert foreground to background
-        set_pixel(fb_data, size, GPoint(x, y), s_bg_color);
-      } else if(gcolor_equal(get_pixel(fb_data, size, GPoint(x, y)), s_bg_color)) {
-        // Invert background to foreground
-        set_pixel(fb_data, size, GPoint(x, y), s_fg_color);
-      }
+    uint8_t *row = &fb_data[(y * bounds.size.w) + frame.origin.x];
+    for(int x = 0; x < frame.size.w; x++) {
+      row[x] = s_lut[row[x]];
     }
   }
 
@@ -49,8 +39,13 @@ InverterLayerCompat *inverter_layer_compat_create(GRect bounds) {
 }
 
 void inverter_layer_compat_set_colors(GColor fg, GColor bg) {
-  s_fg_color = fg;
-  s_bg_color = bg;
+  // Swap fg and bg, leave everything else
+  for(int i = 0; i < 256; i++) {
+    s_lut[i] = i;
+  }
+  s_lut[fg.argb] = bg.argb;
+  s_lut[bg.argb] = fg.argb;
+  s_colors_set = true;
 }
 
 void inverter_layer_compat_destroy(InverterLayerCompat *this) {
@@ -1,61 +1,76 @@
 #include "InverterLayerCompat.h"
 
-#if defined(PBL_BW)
-static bool byte_get_bit(uint8_t *byte, uint8_t bit) {
-  return ((*byte) >> bit) & 1;
-}
-
-static void byte_set_bit(uint8_t *byte, uint8_t bit, uint8_t value) {
-  *byte ^= (-value ^ *byte) & (1 << bit);
-}
-#endif
-
-static GColor get_pixel_color(GBitmapDataRowInfo info, GPoint point) {
 #if defined(PBL_COLOR)
-  // Read the single byte color pixel
-  return (GColor){ .argb = info.data[point.x] };
-#elif defined(PBL_BW)
-  // Read the single bit of the correct byte
-  uint8_t byte = point.x / 8;
-  uint8_t bit = point.x % 8; 
-  return byte_get_bit(&info.data[byte], bit) ? GColorWhite : GColorBlack;
-#endif
+static void invert_row(GBitmapDataRowInfo info, int x0, int x1, const uint8_t *lut) {
+  // Look up what each pixel's byte color becomes
+  for (int x = x0; x <= x1; x++) {
+    info.data[x] = lut[info.data[x]];
+  }
 }
-
-static void set_pixel_color(GBitmapDataRowInfo info, GPoint point, 
-                                                                GColor color) {
-#if defined(PBL_COLOR)
-  // Write the pixel's byte color
-  memset(&info.data[point.x], color.argb, 1);
 #elif defined(PBL_BW)
-  // Find the correct byte, then set the appropriate bit
-  uint8_t byte = point.x / 8;
-  uint8_t bit = point.x % 8; 
-  byte_set_bit(&info.data[byte], bit, gcolor_equal(color, GColorWhite) ? 1 : 0);
-#endif
+static void invert_row(GBitmapDataRowInfo info, int x0, int x1, uint8_t from_black, uint8_t from_white) {
+  // Rebuild a whole byte at a time, keeping bits outside the span
+  for (int byte = x0 / 8; byte <= x1 / 8; byte++) {
+    int start = (byte * 8 > x0) ? byte * 8 : x0;
+    int end = ((byte * 8) + 7 < x1) ? (byte * 8) + 7 : x1;
+    uint8_t mask = (uint8_t)((0xFF << (start % 8)) & (0xFF >> (7 - (end % 8))));
+    uint8_t value = info.data[byte];
+    uint8_t inverted = (from_black & ~value) | (from_white & value);
+    info.data[byte] = (value & ~mask) | (inverted & mask);
+  }
 }
+#endif
 
 static void layer_update_proc(Layer *layer, GContext *ctx) {
+  InverterLayerCompatInfo ilc_info = *(InverterLayerCompatInfo*)layer_get_data(layer);
+  if (gcolor_equal(ilc_info.fg_color, ilc_info.bg_color)) {
+    // Nothing would change
+    return;
+  }
+
   // Use framebuffer to emulate inversion
   GBitmap *fb = graphics_capture_frame_buffer(ctx);
   GRect frame = layer_get_frame(layer);
-  InverterLayerCompatInfo ilc_info = *(InverterLayerCompatInfo*)layer_get_data(layer);
+
+  // Only where the frame is on screen, such as while animating in or out
+  GRect fb_bounds = gbitmap_get_bounds(fb);
+  grect_clip(&frame, &fb_bounds);
+
+#if defined(PBL_COLOR)
+  // What each color becomes, so every pixel is a single lookup
+  uint8_t lut[256];
+  for (int i = 0; i < 256; i++) {
+    lut[i] = i;
+  }
+  lut[ilc_info.fg_color.argb] = ilc_info.bg_color.argb;
+  lut[ilc_info.bg_color.argb] = ilc_info.fg_color.argb;
+#elif defined(PBL_BW)
+  // What black and white pixels become, as whole bytes
+  GColor black = gcolor_equal(ilc_info.fg_color, GColorBlack) ? ilc_info.bg_color
+    : (gcolor_equal(ilc_info.bg_color, GColorBlack) ? ilc_info.fg_color : GColorBlack);
+  GColor white = gcolor_equal(ilc_info.fg_color, GColorWhite) ? ilc_info.bg_color
+    : (gcolor_equal(ilc_info.bg_color, GColorWhite) ? ilc_info.fg_color : GColorWhite);
+  uint8_t from_black = gcolor_equal(black, GColorWhite) ? 0xFF : 0x00;
+  uint8_t from_white = gcolor_equal(white, GColorWhite) ? 0xFF : 0x00;
+#endif
 
   // Iterate over the whole frame but only within the layer's bounds
   for (int y = frame.origin.y; y < frame.origin.y + frame.size.h; y++) {
     GBitmapDataRowInfo info = gbitmap_get_data_row_info(fb, y);
 
-    for (int x = frame.origin.x; x < frame.origin.x + frame.size.w; x++) {
-      GColor pixel_color = get_pixel_color(info, GPoint(x, y));
-      
-      if (gcolor_equal(pixel_color, ilc_info.fg_color)) {
-        // Invert foreground to background
-        set_pixel_color(info, GPoint(x, y), ilc_info.bg_color);
-      } else if (gcolor_equal(pixel_color, ilc_info.bg_color)) {
-        // Invert background to foreground
-        set_pixel_color(info, GPoint(x, y), ilc_info.fg_color);
-      }
+    // Round displays have fewer pixels in the top and bottom rows
+    int x0 = (frame.origin.x > info.min_x) ? frame.origin.x : info.min_x;
+    int x1 = frame.origin.x + frame.size.w - 1;
+    x1 = (x1 < info.max_x) ? x1 : info.max_x;
+    if (x0 > x1) {
+      continue;
     }
+
+#if defined(PBL_COLOR)
+    invert_row(info, x0, x1, lut);
+#elif defined(PBL_BW)
+    invert_row(info, x0, x1, from_black, from_white);
+#endif
   }
 
   // Finally
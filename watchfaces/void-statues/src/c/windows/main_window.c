@@ -12,6 +12,7 @@ typedef struct {
 
 static SimpleTime s_current_time, s_anim_time;
 static bool s_animating = true;
+static bool s_is_day;
 
 /*********************************** Drawing **********************************/
 
@@ -99,6 +100,11 @@ static void tick_handler(struct tm *tick_time, TimeUnits units_changed) {
     window_set_background_color(s_window, GColorBlack);
   }
 
+  // The cached frame includes the background
+  if (is_day != s_is_day) {
+    s_is_day = is_day;
+    isometric_invalidate_draw_list();
+  }
   layer_mark_dirty(s_canvas_layer);
 }
 
@@ -118,9 +124,13 @@ static void window_load(Window *window) {
   s_canvas_layer = layer_create(bounds);
   layer_set_update_proc(s_canvas_layer, canvas_layer_update_proc);
   layer_add_child(window_layer, s_canvas_layer);
+
+  // Only draw the statues again when they change
+  isometric_set_draw_list_enabled(true);
 }
 
 static void window_unload(Window *window) {
+  isometric_set_draw_list_enabled(false);
   layer_destroy(s_canvas_layer);
 
   window_destroy(s_window);
@@ -137,6 +147,7 @@ void main_window_push() {
   s_current_time.minute_units = tm_now->tm_min % 10;
 
   bool is_day = tm_now->tm_hour >= 6 && tm_now->tm_hour < 18;
+  s_is_day = is_day;
   drawing_set_colors(
     is_day ? GColorBlack : GColorWhite,
     is_day ? GColorLightGray : GColorDarkGray,